@@ -0,0 +1,60 @@
+module;
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+
+module chess.alloc_tracking;
+
+namespace chess::alloc {
+
+namespace {
+
+std::atomic<bool> trackingEnabled{false}, failOnAllocation{false};
+
+// Plain thread locals: the hooks may run before or after anything with a
+// constructor on this thread.
+thread_local AllocationCounts threadCounts;
+thread_local bool insideRegion = false;
+
+} // namespace
+
+void setTrackingEnabled(const bool enabled) {
+  trackingEnabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool isTrackingEnabled() {
+  return trackingEnabled.load(std::memory_order_relaxed);
+}
+
+auto getThreadAllocations() -> AllocationCounts { return threadCounts; }
+
+void setFailOnAllocation(const bool fail) {
+  failOnAllocation.store(fail, std::memory_order_relaxed);
+}
+
+AllocationFreeRegion::AllocationFreeRegion() : wasInside_(insideRegion) {
+  insideRegion = true;
+}
+
+AllocationFreeRegion::~AllocationFreeRegion() { insideRegion = wasInside_; }
+
+void recordAllocation(const size_t bytes) {
+  if (!trackingEnabled.load(std::memory_order_relaxed))
+    return;
+
+  ++threadCounts.allocations;
+  threadCounts.bytes += bytes;
+
+  if (insideRegion && failOnAllocation.load(std::memory_order_relaxed)) {
+    // Nothing that could allocate again from here on.
+    std::fprintf(stderr,
+                 "Allocation of %zu bytes inside an allocation-free region\n",
+                 bytes);
+    std::abort();
+  }
+}
+
+} // namespace chess::alloc
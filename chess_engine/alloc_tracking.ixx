@@ -0,0 +1,47 @@
+module;
+
+#include <cstddef>
+#include <cstdint>
+
+export module chess.alloc_tracking;
+
+export namespace chess::alloc {
+
+export struct AllocationCounts {
+  uint64_t allocations = 0;
+  uint64_t bytes = 0;
+
+  AllocationCounts operator-(const AllocationCounts &other) const {
+    return {allocations - other.allocations, bytes - other.bytes};
+  }
+};
+
+// Counting is off until asked for, leaving the global operator new hooks
+// with a single relaxed load on top of malloc.
+export void setTrackingEnabled(bool enabled);
+export [[nodiscard]] bool isTrackingEnabled();
+
+// What the calling thread has allocated while tracking was on.
+export [[nodiscard]] auto getThreadAllocations() -> AllocationCounts;
+
+// With this on, an allocation inside an AllocationFreeRegion prints a
+// message and aborts, so a regression is caught where it happens.
+export void setFailOnAllocation(bool fail);
+
+// Marks code on the calling thread that must not allocate, such as the
+// search tree. Regions nest.
+export class AllocationFreeRegion {
+private:
+  bool wasInside_;
+
+public:
+  AllocationFreeRegion();
+  ~AllocationFreeRegion();
+  AllocationFreeRegion(const AllocationFreeRegion &) = delete;
+  AllocationFreeRegion &operator=(const AllocationFreeRegion &) = delete;
+};
+
+// Called by the replaced global operator new.
+export void recordAllocation(size_t bytes);
+
+} // namespace chess::alloc
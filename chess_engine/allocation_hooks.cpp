@@ -0,0 +1,78 @@
+/**
+ * @file allocation_hooks.cpp
+ * @brief Replaces the global allocation functions so that chess.alloc_tracking
+ * sees every heap allocation. They have to live outside any module.
+ */
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#ifdef _MSC_VER
+#include <malloc.h>
+#endif
+
+import chess.alloc_tracking;
+
+namespace {
+
+void *allocate(std::size_t size) {
+  chess::alloc::recordAllocation(size);
+  if (void *pointer = std::malloc(size ? size : 1))
+    return pointer;
+  throw std::bad_alloc();
+}
+
+void *allocateAligned(std::size_t size, const std::align_val_t alignment) {
+  chess::alloc::recordAllocation(size);
+  const auto align = static_cast<std::size_t>(alignment);
+#ifdef _MSC_VER
+  void *pointer = _aligned_malloc(size ? size : 1, align);
+#else
+  // aligned_alloc wants the size rounded up to the alignment.
+  void *pointer = std::aligned_alloc(align, (size + align - 1) / align * align);
+#endif
+  if (!pointer)
+    throw std::bad_alloc();
+  return pointer;
+}
+
+void deallocateAligned(void *pointer) {
+#ifdef _MSC_VER
+  _aligned_free(pointer);
+#else
+  std::free(pointer);
+#endif
+}
+
+} // namespace
+
+void *operator new(std::size_t size) { return allocate(size); }
+void *operator new[](std::size_t size) { return allocate(size); }
+void operator delete(void *pointer) noexcept { std::free(pointer); }
+void operator delete[](void *pointer) noexcept { std::free(pointer); }
+void operator delete(void *pointer, std::size_t) noexcept {
+  std::free(pointer);
+}
+void operator delete[](void *pointer, std::size_t) noexcept {
+  std::free(pointer);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+  return allocateAligned(size, alignment);
+}
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+  return allocateAligned(size, alignment);
+}
+void operator delete(void *pointer, std::align_val_t) noexcept {
+  deallocateAligned(pointer);
+}
+void operator delete[](void *pointer, std::align_val_t) noexcept {
+  deallocateAligned(pointer);
+}
+void operator delete(void *pointer, std::size_t, std::align_val_t) noexcept {
+  deallocateAligned(pointer);
+}
+void operator delete[](void *pointer, std::size_t, std::align_val_t) noexcept {
+  deallocateAligned(pointer);
+}
@@ -0,0 +1,94 @@
+module;
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+module chess.attack_map;
+
+import chess.core;
+import chess.shifts;
+import chess.board_state;
+import chess.generator_helpers;
+
+namespace chess::move_generator {
+
+using chess::board::Bitboard;
+using chess::board::BoardState;
+using chess::board::Color;
+using chess::board::Name;
+
+namespace {
+
+Bitboard getPieceAttacks(const Name name, const uint8_t index,
+                         const Bitboard empty) {
+  switch (name) {
+  case Name::KNIGHT:
+    return getKnightAttacks(index);
+  case Name::BISHOP:
+    return getBishopAttacks(index, empty);
+  case Name::ROOK:
+    return getRookAttacks(index, empty);
+  case Name::QUEEN:
+    return getBishopAttacks(index, empty) | getRookAttacks(index, empty);
+  default:
+    return getKingAttacks(index);
+  }
+}
+
+} // namespace
+
+auto buildAttackMap(const BoardState &boardState) -> AttackMap {
+  AttackMap map;
+  const Bitboard empty = boardState.getEmpty();
+
+  for (const Color color : {Color::WHITE, Color::BLACK}) {
+    const size_t side = static_cast<size_t>(color);
+    Bitboard &all = map.all[side], &multiple = map.multiple[side];
+
+    const Bitboard pawns = boardState.getPieces(color, Name::PAWN);
+    const Bitboard pawnAttacks = getPawnAttacks(color, pawns);
+    map.byName[side][static_cast<size_t>(Name::PAWN)] = pawnAttacks;
+    // Squares attacked by two pawns at once.
+    multiple = color == Color::WHITE
+                   ? chess::board::shiftNorthWest(pawns) &
+                         chess::board::shiftNorthEast(pawns)
+                   : chess::board::shiftSouthWest(pawns) &
+                         chess::board::shiftSouthEast(pawns);
+    all = pawnAttacks;
+
+    for (size_t nameIndex = static_cast<size_t>(Name::KNIGHT);
+         nameIndex < static_cast<size_t>(Name::COUNT); ++nameIndex) {
+      const Name name = static_cast<Name>(nameIndex);
+      Bitboard pieces = boardState.getPieces(color, name);
+      while (auto pieceInfo = chess::board::getNextPiece(pieces)) {
+        const Bitboard attacks =
+            getPieceAttacks(name, pieceInfo->index, empty);
+        if (name != Name::KING && map.pieceCount < map.pieces.size())
+          map.pieces[map.pieceCount++] = {attacks, pieceInfo->index, name,
+                                          color};
+        map.byName[side][nameIndex] |= attacks;
+        multiple |= all & attacks;
+        all |= attacks;
+      }
+    }
+  }
+  return map;
+}
+
+auto isInCheck(const Color color, const BoardState &boardState,
+               const AttackMap &attacks) -> bool {
+  return boardState.getPieces(color, Name::KING) &
+         attacks.getAttacks(chess::board::getOppositeColor(color));
+}
+
+auto getHangingPieces(const Color color, const BoardState &boardState,
+                      const AttackMap &attacks) -> Bitboard {
+  const Bitboard pieces = boardState.getPieces(color) &
+                          ~boardState.getPieces(color, Name::PAWN) &
+                          ~boardState.getPieces(color, Name::KING);
+  return pieces & attacks.getAttacks(chess::board::getOppositeColor(color)) &
+         ~attacks.getAttacks(color);
+}
+
+} // namespace chess::move_generator
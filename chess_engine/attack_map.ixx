@@ -0,0 +1,63 @@
+module;
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+export module chess.attack_map;
+
+import chess.core;
+import chess.board_state;
+
+export namespace chess::move_generator {
+
+// Every attacked square of a position, gathered in one pass over the
+// pieces, for the evaluation, check detection and move ordering of a node
+// to share instead of each rerunning the attack generators.
+export struct AttackMap {
+  struct PieceAttacks {
+    chess::board::Bitboard attacks;
+    uint8_t index;
+    chess::board::Name name;
+    chess::board::Color color;
+  };
+
+  // Knights, bishops, rooks and queens, each with its own attacks.
+  std::array<PieceAttacks, 32> pieces;
+  size_t pieceCount = 0;
+
+  // By color, then by kind of piece.
+  std::array<std::array<chess::board::Bitboard,
+                        static_cast<size_t>(chess::board::Name::COUNT)>,
+             2>
+      byName{};
+  std::array<chess::board::Bitboard, 2> all{};
+  // Attacked by at least two pieces of the color.
+  std::array<chess::board::Bitboard, 2> multiple{};
+
+  [[nodiscard]] chess::board::Bitboard
+  getAttacks(const chess::board::Color color) const {
+    return all[static_cast<size_t>(color)];
+  }
+  [[nodiscard]] chess::board::Bitboard
+  getAttacks(const chess::board::Color color,
+             const chess::board::Name name) const {
+    return byName[static_cast<size_t>(color)][static_cast<size_t>(name)];
+  }
+};
+
+export auto buildAttackMap(const chess::board::BoardState &boardState)
+    -> AttackMap;
+
+export auto isInCheck(const chess::board::Color color,
+                      const chess::board::BoardState &boardState,
+                      const AttackMap &attacks) -> bool;
+
+// Pieces other than pawns and the king that the opponent attacks and
+// nothing defends.
+export auto getHangingPieces(const chess::board::Color color,
+                             const chess::board::BoardState &boardState,
+                             const AttackMap &attacks)
+    -> chess::board::Bitboard;
+
+} // namespace chess::move_generator
@@ -0,0 +1,305 @@
+module;
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#if defined(__AVX2__) && !defined(CHESS_NO_SIMD)
+#define CHESS_BATCH_AVX2
+#include <immintrin.h>
+#endif
+
+module chess.batch_evaluation;
+
+import chess.core;
+import chess.score;
+import chess.masks;
+import chess.board_state;
+import chess.pawn_structure;
+
+namespace chess::evaluation {
+
+using chess::board::Bitboard;
+using chess::board::BoardState;
+using chess::board::Color;
+using chess::board::Name;
+using chess::board::Score;
+
+namespace {
+
+constexpr size_t KINDS = 2 * static_cast<size_t>(Name::COUNT);
+
+constexpr Bitboard getRow(const size_t row) { return 0xFFULL << (row * 8); }
+
+#pragma region scalar
+Score evaluatePawnSide(const Color us, const Bitboard ourPawns,
+                       const Bitboard theirPawns) {
+  const PawnClasses classes = classifyPawns(us, ourPawns, theirPawns);
+  Score score = DOUBLED_PAWN * std::popcount(classes.doubled) +
+                ISOLATED_PAWN * std::popcount(classes.isolated) +
+                BACKWARD_PAWN * std::popcount(classes.backward);
+  for (size_t row = 1; row < 7; ++row)
+    score += PASSED_PAWN[us == Color::WHITE ? 7 - row : row] *
+             std::popcount(classes.passed & getRow(row));
+  return score;
+}
+
+int evaluateOne(const PositionBatch &batch, const size_t i) {
+  Score score = 0;
+  int phase = 0;
+  for (const Color color : {Color::WHITE, Color::BLACK}) {
+    for (size_t name = 0; name < static_cast<size_t>(Name::COUNT); ++name) {
+      Bitboard pieces = batch.getPieces(color, static_cast<Name>(name))[i];
+      phase += chess::board::PHASE_WEIGHTS[name] * std::popcount(pieces);
+      for (; pieces; pieces &= pieces - 1)
+        score += chess::board::PIECE_SQUARE_SCORES[static_cast<size_t>(
+            color)][name][std::countr_zero(pieces)];
+    }
+  }
+
+  const Bitboard whitePawns = batch.getPieces(Color::WHITE, Name::PAWN)[i],
+                 blackPawns = batch.getPieces(Color::BLACK, Name::PAWN)[i];
+  score += evaluatePawnSide(Color::WHITE, whitePawns, blackPawns) -
+           evaluatePawnSide(Color::BLACK, blackPawns, whitePawns);
+
+  const int result = chess::board::taper(
+      score, phase < chess::board::MAX_PHASE ? phase : chess::board::MAX_PHASE);
+  return batch.getBlackToMove()[i] ? -result : result;
+}
+#pragma endregion
+
+#ifdef CHESS_BATCH_AVX2
+#pragma region avx2
+// Four positions per register, one bitboard per 64 bit lane. Scores are
+// kept in the low half of each lane; the upper halves are never read.
+using Vector = __m256i;
+
+// PIECE_SQUARE_SCORES as one flat table for the gathers, indexed by
+// (color * 6 + name) * 64 + square.
+constexpr auto flattenPieceSquareScores() {
+  std::array<Score, KINDS * 64> scores{};
+  for (size_t kind = 0; kind < KINDS; ++kind)
+    for (size_t square = 0; square < 64; ++square)
+      scores[kind * 64 + square] =
+          chess::board::PIECE_SQUARE_SCORES[kind / 6][kind % 6][square];
+  return scores;
+}
+alignas(32) constexpr std::array<Score, KINDS * 64> FLAT_PIECE_SQUARE_SCORES =
+    flattenPieceSquareScores();
+
+Vector load(const Bitboard *bitboards) {
+  return _mm256_loadu_si256(reinterpret_cast<const Vector *>(bitboards));
+}
+
+Vector broadcast(const Bitboard bitboard) {
+  return _mm256_set1_epi64x(static_cast<long long>(bitboard));
+}
+
+Vector shiftNorth(const Vector b) { return _mm256_srli_epi64(b, 8); }
+Vector shiftSouth(const Vector b) { return _mm256_slli_epi64(b, 8); }
+Vector shiftForward(const Color color, const Vector b) {
+  return color == Color::WHITE ? shiftNorth(b) : shiftSouth(b);
+}
+
+Vector getAdjacentFiles(const Vector b) {
+  const Vector west =
+      _mm256_srli_epi64(_mm256_andnot_si256(broadcast(chess::board::FILE_A), b),
+                        1);
+  const Vector east =
+      _mm256_slli_epi64(_mm256_andnot_si256(broadcast(chess::board::FILE_H), b),
+                        1);
+  return _mm256_or_si256(west, east);
+}
+
+Vector fillNorth(Vector b) {
+  b = _mm256_or_si256(b, _mm256_srli_epi64(b, 8));
+  b = _mm256_or_si256(b, _mm256_srli_epi64(b, 16));
+  return _mm256_or_si256(b, _mm256_srli_epi64(b, 32));
+}
+
+Vector fillSouth(Vector b) {
+  b = _mm256_or_si256(b, _mm256_slli_epi64(b, 8));
+  b = _mm256_or_si256(b, _mm256_slli_epi64(b, 16));
+  return _mm256_or_si256(b, _mm256_slli_epi64(b, 32));
+}
+
+Vector getFrontSpan(const Color color, const Vector pawns) {
+  return color == Color::WHITE ? fillNorth(shiftNorth(pawns))
+                               : fillSouth(shiftSouth(pawns));
+}
+
+// There is no 64 bit popcount before AVX-512: look up each nibble, then sum
+// the bytes of every lane.
+Vector popcount(const Vector b) {
+  const Vector table =
+      _mm256_setr_epi8(0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4, //
+                       0, 1, 1, 2, 1, 2, 2, 3, 1, 2, 2, 3, 2, 3, 3, 4);
+  const Vector nibbles = _mm256_set1_epi8(0x0F);
+  const Vector low = _mm256_and_si256(b, nibbles),
+               high = _mm256_and_si256(_mm256_srli_epi16(b, 4), nibbles);
+  const Vector counts = _mm256_add_epi8(_mm256_shuffle_epi8(table, low),
+                                        _mm256_shuffle_epi8(table, high));
+  return _mm256_sad_epu8(counts, _mm256_setzero_si256());
+}
+
+Vector multiply(const Vector counts, const Score score) {
+  return _mm256_mul_epi32(counts, _mm256_set1_epi32(score));
+}
+
+Vector evaluatePawnSide(const Color us, const Vector ourPawns,
+                        const Vector theirPawns) {
+  const Color them = getOppositeColor(us);
+  const Vector theirAttacks =
+      shiftForward(them, getAdjacentFiles(theirPawns));
+  const Vector ourAttackSpan = getAdjacentFiles(getFrontSpan(us, ourPawns));
+  const Vector theirFrontSpan = getFrontSpan(them, theirPawns);
+
+  const Vector doubled =
+      _mm256_and_si256(ourPawns, getFrontSpan(them, ourPawns));
+  const Vector isolated = _mm256_andnot_si256(
+      getAdjacentFiles(_mm256_or_si256(fillNorth(ourPawns), fillSouth(ourPawns))),
+      ourPawns);
+  const Vector contestedStops =
+      _mm256_andnot_si256(ourAttackSpan, theirAttacks);
+  const Vector backward = _mm256_and_si256(
+      _mm256_andnot_si256(isolated, ourPawns),
+      shiftForward(them, contestedStops));
+  const Vector passed = _mm256_andnot_si256(
+      _mm256_or_si256(_mm256_or_si256(doubled, theirFrontSpan),
+                      getAdjacentFiles(theirFrontSpan)),
+      ourPawns);
+
+  Vector score = _mm256_add_epi64(
+      _mm256_add_epi64(multiply(popcount(doubled), DOUBLED_PAWN),
+                       multiply(popcount(isolated), ISOLATED_PAWN)),
+      multiply(popcount(backward), BACKWARD_PAWN));
+  for (size_t row = 1; row < 7; ++row)
+    score = _mm256_add_epi64(
+        score,
+        multiply(popcount(_mm256_and_si256(passed, broadcast(getRow(row)))),
+                 PASSED_PAWN[us == Color::WHITE ? 7 - row : row]));
+  return score;
+}
+
+// Sum of the piece-square scores of `pieces`, a bitboard of kind `kind` per
+// lane. Works on 32 bit halves so the square of the lowest set bit can be
+// read off the exponent of its conversion to float; each round gathers one
+// score for every half that still has pieces left.
+Vector sumPieceSquareScores(Vector pieces, const int kind) {
+  const Vector zero = _mm256_setzero_si256();
+  const Vector base = _mm256_add_epi32(
+      _mm256_set1_epi32(kind * 64 - 127),
+      _mm256_setr_epi32(0, 32, 0, 32, 0, 32, 0, 32));
+  Vector sum = zero;
+  while (!_mm256_testz_si256(pieces, pieces)) {
+    const Vector lowest =
+        _mm256_and_si256(pieces, _mm256_sub_epi32(zero, pieces));
+    const Vector exponent = _mm256_and_si256(
+        _mm256_srli_epi32(_mm256_castps_si256(_mm256_cvtepi32_ps(lowest)), 23),
+        _mm256_set1_epi32(0xFF));
+    const Vector occupied =
+        _mm256_xor_si256(_mm256_cmpeq_epi32(pieces, zero),
+                         _mm256_set1_epi32(-1));
+    sum = _mm256_add_epi32(
+        sum, _mm256_mask_i32gather_epi32(
+                 zero, FLAT_PIECE_SQUARE_SCORES.data(),
+                 _mm256_add_epi32(base, exponent), occupied, 4));
+    pieces = _mm256_and_si256(pieces,
+                              _mm256_sub_epi32(pieces, _mm256_set1_epi32(1)));
+  }
+  // Fold the upper half's sum into the lower one.
+  return _mm256_add_epi32(sum, _mm256_srli_epi64(sum, 32));
+}
+
+void evaluateFour(const PositionBatch &batch, const size_t i, int *scores) {
+  Vector score = _mm256_setzero_si256(), phase = _mm256_setzero_si256();
+  for (size_t name = 0; name < static_cast<size_t>(Name::COUNT); ++name) {
+    const Vector white =
+        load(batch.getPieces(Color::WHITE, static_cast<Name>(name)) + i);
+    const Vector black =
+        load(batch.getPieces(Color::BLACK, static_cast<Name>(name)) + i);
+    if (chess::board::PHASE_WEIGHTS[name])
+      phase = _mm256_add_epi64(
+          phase, multiply(popcount(_mm256_or_si256(white, black)),
+                          chess::board::PHASE_WEIGHTS[name]));
+    score = _mm256_add_epi32(score,
+                             sumPieceSquareScores(white, static_cast<int>(name)));
+    score = _mm256_add_epi32(
+        score, sumPieceSquareScores(black, static_cast<int>(name + 6)));
+  }
+  phase = _mm256_min_epi32(phase, _mm256_set1_epi64x(chess::board::MAX_PHASE));
+
+  const Vector whitePawns = load(batch.getPieces(Color::WHITE, Name::PAWN) + i),
+               blackPawns = load(batch.getPieces(Color::BLACK, Name::PAWN) + i);
+  score = _mm256_add_epi32(
+      score, _mm256_sub_epi32(
+                 evaluatePawnSide(Color::WHITE, whitePawns, blackPawns),
+                 evaluatePawnSide(Color::BLACK, blackPawns, whitePawns)));
+
+  // taper: sign extend both halves, blend, and divide by MAX_PHASE. The
+  // numerator stays far below 2^24, so the float division truncates to the
+  // same quotient as the integer one.
+  const Vector middlegame =
+      _mm256_srai_epi32(_mm256_slli_epi32(score, 16), 16);
+  const Vector endgame =
+      _mm256_srai_epi32(_mm256_add_epi32(score, _mm256_set1_epi32(0x8000)), 16);
+  const Vector blended = _mm256_add_epi32(
+      _mm256_mullo_epi32(middlegame, phase),
+      _mm256_mullo_epi32(endgame,
+                         _mm256_sub_epi32(
+                             _mm256_set1_epi32(chess::board::MAX_PHASE), phase)));
+  Vector result = _mm256_cvttps_epi32(
+      _mm256_div_ps(_mm256_cvtepi32_ps(blended),
+                    _mm256_set1_ps(static_cast<float>(chess::board::MAX_PHASE))));
+
+  const Vector blackToMove = load(batch.getBlackToMove() + i);
+  result = _mm256_sub_epi32(_mm256_xor_si256(result, blackToMove), blackToMove);
+  result = _mm256_permutevar8x32_epi32(
+      result, _mm256_setr_epi32(0, 2, 4, 6, 0, 2, 4, 6));
+  _mm_storeu_si128(reinterpret_cast<__m128i *>(scores),
+                   _mm256_castsi256_si128(result));
+}
+#pragma endregion
+#endif
+
+} // namespace
+
+void PositionBatch::clear() {
+  for (std::vector<Bitboard> &pieces : pieces_)
+    pieces.clear();
+  blackToMove_.clear();
+}
+
+void PositionBatch::add(const BoardState &boardState) {
+  for (const Color color : {Color::WHITE, Color::BLACK})
+    for (size_t name = 0; name < static_cast<size_t>(Name::COUNT); ++name)
+      pieces_[static_cast<size_t>(color) * 6 + name].push_back(
+          boardState.getPieces(color, static_cast<Name>(name)));
+  blackToMove_.push_back(boardState.getTurnColor() == Color::BLACK ? ~0ULL
+                                                                   : 0ULL);
+}
+
+void PositionBatch::reserve(const size_t count) {
+  for (std::vector<Bitboard> &pieces : pieces_)
+    pieces.reserve(count);
+  blackToMove_.reserve(count);
+}
+
+void evaluateBatch(const PositionBatch &batch, const std::span<int> scores) {
+  if (scores.size() < batch.size())
+    throw std::logic_error("Batch evaluation needs a score per position");
+
+  size_t i = 0;
+#ifdef CHESS_BATCH_AVX2
+  for (; i + 4 <= batch.size(); i += 4)
+    evaluateFour(batch, i, scores.data() + i);
+#endif
+  for (; i < batch.size(); ++i)
+    scores[i] = evaluateOne(batch, i);
+}
+
+} // namespace chess::evaluation
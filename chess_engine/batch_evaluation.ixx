@@ -0,0 +1,46 @@
+module;
+
+#include <array>
+#include <cstddef>
+#include <span>
+#include <vector>
+
+export module chess.batch_evaluation;
+
+import chess.core;
+import chess.board_state;
+
+export namespace chess::evaluation {
+
+// Positions stored as one array per kind of piece rather than one board per
+// position, so the same bitboard of consecutive positions sits side by side
+// and loads straight into a vector register.
+export class PositionBatch {
+private:
+  std::array<std::vector<chess::board::Bitboard>, 12> pieces_;
+  // All ones where black is to move, as a ready-made negation mask.
+  std::vector<chess::board::Bitboard> blackToMove_;
+
+public:
+  void clear();
+  void add(const chess::board::BoardState &boardState);
+  void reserve(size_t count);
+
+  [[nodiscard]] size_t size() const { return blackToMove_.size(); }
+  [[nodiscard]] const chess::board::Bitboard *
+  getPieces(const chess::board::Color color,
+            const chess::board::Name name) const {
+    return pieces_[static_cast<size_t>(color) * 6 + static_cast<size_t>(name)]
+        .data();
+  }
+  [[nodiscard]] const chess::board::Bitboard *getBlackToMove() const {
+    return blackToMove_.data();
+  }
+};
+
+// evaluateStatic of every position in `batch`, into `scores`, which must
+// hold at least batch.size() values. Four positions at a time with AVX2,
+// one at a time otherwise; the results are the same either way.
+export void evaluateBatch(const PositionBatch &batch, std::span<int> scores);
+
+} // namespace chess::evaluation
@@ -0,0 +1,138 @@
+module;
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+module chess.bench;
+
+import chess.alloc_tracking;
+import chess.board_state;
+import chess.fen;
+import chess.engine;
+import chess.nnue;
+import chess.search;
+import chess.perf_counters;
+import chess.trace;
+
+namespace chess::bench {
+
+namespace {
+
+// Same every run, whatever the options of an interactive session.
+constexpr size_t BENCH_HASH_MB = 16;
+
+} // namespace
+
+auto runBench(std::ostream &out, const BenchOptions &options) -> BenchResult {
+  std::optional<chess::perf::PerfCounters> counters;
+  if (options.hardwareCounters)
+    counters.emplace();
+  const bool wasTracking = chess::alloc::isTrackingEnabled();
+  if (options.allocations || options.failOnAllocation)
+    chess::alloc::setTrackingEnabled(true);
+  chess::alloc::setFailOnAllocation(options.failOnAllocation);
+  if (options.trace) {
+    chess::trace::clear();
+    chess::trace::setEnabled(true);
+  }
+
+  // Loaded once, as an engine would at startup.
+  const std::shared_ptr<const chess::nnue::Network> network =
+      options.networkFile.empty()
+          ? nullptr
+          : chess::nnue::Network::load(options.networkFile);
+
+  BenchResult result;
+  for (size_t i = 0; i < BENCH_POSITIONS.size(); ++i) {
+    const auto position = chess::board::parseFen(BENCH_POSITIONS[i]);
+    if (!position)
+      throw std::logic_error("Invalid bench position");
+
+    // A fresh engine per position, so none depends on the ones before it.
+    chess::engine::Engine engine;
+    engine.setHashSize(BENCH_HASH_MB);
+    engine.setHelperThreadCount(options.threads - 1);
+    engine.setNetwork(network);
+    if (counters)
+      counters->start();
+    const chess::alloc::AllocationCounts allocationsBefore =
+        chess::alloc::getThreadAllocations();
+    const auto start = std::chrono::steady_clock::now();
+    const chess::search::SearchResult searchResult = engine.search(
+        *position, {}, chess::search::SearchLimits{options.depth});
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    const chess::alloc::AllocationCounts allocated =
+        chess::alloc::getThreadAllocations() - allocationsBefore;
+    if (counters)
+      counters->stop();
+
+    result.elapsed +=
+        std::chrono::duration_cast<std::chrono::milliseconds>(elapsed);
+    result.nodes += searchResult.nodes;
+    result.allocations += allocated.allocations;
+    result.allocatedBytes += allocated.bytes;
+
+    out << "Position " << i + 1 << '/' << BENCH_POSITIONS.size() << ": "
+        << searchResult.nodes << " nodes\n";
+  }
+
+  out << "\nTotal time (ms) : " << result.elapsed.count()
+      << "\nNodes searched  : " << result.nodes
+      << "\nNodes/second    : " << result.getNodesPerSecond() << std::endl;
+  if (options.allocations && result.nodes > 0)
+    out << "Allocations/node : "
+        << static_cast<double>(result.allocations) / result.nodes
+        << "\nBytes/node       : "
+        << static_cast<double>(result.allocatedBytes) / result.nodes
+        << std::endl;
+  if (counters)
+    chess::perf::printCounters(out, *counters, result.nodes);
+
+  if (options.trace) {
+    chess::trace::setEnabled(false);
+    std::ofstream traceOut{std::string(BENCH_TRACE_FILE)};
+    chess::trace::writeChromeTrace(traceOut);
+    out << "Trace written to " << BENCH_TRACE_FILE << std::endl;
+  }
+
+  chess::alloc::setFailOnAllocation(false);
+  chess::alloc::setTrackingEnabled(wasTracking);
+  return result;
+}
+
+auto parseBenchArguments(const std::span<const std::string_view> words)
+    -> BenchOptions {
+  BenchOptions options;
+  for (const std::string_view word : words) {
+    if (word == "counters")
+      options.hardwareCounters = true;
+    else if (word == "allocs")
+      options.allocations = true;
+    else if (word == "noalloc")
+      options.failOnAllocation = true;
+    else if (word == "trace")
+      options.trace = true;
+    else if (word.starts_with("threads="))
+      std::from_chars(word.data() + 8, word.data() + word.size(),
+                      options.threads);
+    else if (word.ends_with(".nnue"))
+      options.networkFile = word;
+    else
+      std::from_chars(word.data(), word.data() + word.size(), options.depth);
+  }
+  options.threads = std::max<size_t>(options.threads, 1);
+  return options;
+}
+
+} // namespace chess::bench
@@ -0,0 +1,76 @@
+module;
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+
+export module chess.bench;
+
+export namespace chess::bench {
+
+// Openings, middlegames and endings, with checks, promotions, castling and
+// en passant among them.
+export inline constexpr std::array<std::string_view, 12> BENCH_POSITIONS = {
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1",
+    "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+    "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1",
+    "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1",
+    "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8",
+    "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+    "r1bqkb1r/pppp1ppp/2n2n2/4p2Q/2B1P3/8/PPPP1PPP/RNB1K1NR w KQkq - 4 4",
+    "2r3k1/pp3ppp/2n1b3/q2pP3/3P4/P1PB1N2/5PPP/R2Q1RK1 b - - 0 18",
+    "r1bq1rk1/pp2ppbp/2np1np1/8/3NP3/2N1BP2/PPPQ2PP/R3KB1R w KQ - 3 9",
+    "8/8/4k3/3p4/3P4/4K3/8/8 w - - 0 1",
+    "6k1/5ppp/8/8/8/8/5PPP/3R2K1 w - - 0 1",
+    "8/8/1k6/8/2PK4/8/8/8 w - - 0 1",
+};
+
+export inline constexpr int DEFAULT_BENCH_DEPTH = 9;
+
+export struct BenchOptions {
+  int depth = DEFAULT_BENCH_DEPTH;
+  // Search threads per position. The node signature is only reproducible
+  // with one; more measure how the lazy SMP search scales.
+  size_t threads = 1;
+  // Hardware counters per node, where the platform has them.
+  bool hardwareCounters = false;
+  // Heap allocations and bytes per node.
+  bool allocations = false;
+  // Abort on the first allocation inside a search tree.
+  bool failOnAllocation = false;
+  // Chrome trace of the whole run, written to BENCH_TRACE_FILE.
+  bool trace = false;
+  // Network to evaluate with; the hand-written evaluation when empty.
+  std::string networkFile;
+};
+
+export inline constexpr std::string_view BENCH_TRACE_FILE = "bench_trace.json";
+
+export struct BenchResult {
+  uint64_t nodes = 0;
+  std::chrono::milliseconds elapsed{};
+  uint64_t allocations = 0;
+  uint64_t allocatedBytes = 0;
+
+  [[nodiscard]] uint64_t getNodesPerSecond() const {
+    return elapsed.count() > 0 ? nodes * 1000 / elapsed.count() : nodes;
+  }
+};
+
+// Searches a built-in set of positions to `depth`, one after another, on a
+// single thread with a cleared table of fixed size. The node total is a
+// signature of the search: it only changes when the search does, whatever
+// the machine or its load, while the time and speed track performance.
+export auto runBench(std::ostream &out, const BenchOptions &options = {})
+    -> BenchResult;
+
+// Reads the words after `bench`: a depth, and any of `counters`, `allocs`,
+// `noalloc` and `trace`. Unknown words are ignored.
+export auto parseBenchArguments(std::span<const std::string_view> words)
+    -> BenchOptions;
+
+} // namespace chess::bench
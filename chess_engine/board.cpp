@@ -1,99 +1,188 @@
-#include "board.hpp"
-
-namespace chess_board {
-
-namespace {
-
-void initPieces(BoardState &boardState) {
-  static const char boardLayout[8][8] = {
-      {'r', 'n', 'b', 'q', 'k', 'b', 'n', 'r'},
-      {'p', 'p', 'p', 'p', 'p', 'p', 'p', 'p'},
-      {' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '},
-      {' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '},
-      {' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '},
-      {' ', ' ', ' ', ' ', ' ', ' ', ' ', ' '},
-      {'P', 'P', 'P', 'P', 'P', 'P', 'P', 'P'},
-      {'R', 'N', 'B', 'Q', 'K', 'B', 'N', 'R'}};
-
-  auto getPieceNameFromChar = [](char pieceChar) -> std::optional<Name> {
-    switch (tolower(pieceChar)) {
-    case 'p':
-      return Name::PAWN;
-    case 'n':
-      return Name::KNIGHT;
-    case 'b':
-      return Name::BISHOP;
-    case 'r':
-      return Name::ROOK;
-    case 'q':
-      return Name::QUEEN;
-    case 'k':
-      return Name::KING;
-    default:
-      return std::nullopt; // Indicate an empty space or invalid char
-    }
-  };
+module;
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <iomanip>
+#include <iostream>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+module chess.board;
+
+import chess.core;
+import chess.board_state;
+import chess.fen;
+import chess.move;
+import chess.input;
+import chess.move_executor;
+import chess.move_generator;
+import chess.notation;
+import chess.nnue;
+import chess.search;
+import chess.engine;
+import chess.search_stats;
+import chess.repetition;
+
+namespace chess::board {
+
+void Board::printLegalMoves() const {
+  MoveList legalMoves;
+  chess::move_generator::getLegalMoves(boardState_, legalMoves);
+  std::array<char, chess::notation::MAX_SAN_LENGTH> buffer;
+  for (const Move &move : legalMoves) {
+    const auto result = chess::notation::toSan(
+        buffer.data(), buffer.data() + buffer.size(), boardState_, move);
+    std::cout << std::string_view(buffer.data(), result.ptr - buffer.data())
+              << ' ';
+  }
+  std::cout << '\n' << std::endl;
+}
 
-  for (std::uint8_t rank = 0; rank < 8; ++rank) {
-    for (std::uint8_t file = 0; file < 8; ++file) {
-      char pieceChar = boardLayout[rank][file];
-      if (auto pieceNameOpt = getPieceNameFromChar(pieceChar)) {
-        const Bitboard mask = 1ULL << (rank * 8 + file);
-        Color color = isupper(pieceChar) ? Color::WHITE : Color::BLACK;
-        boardState.addPiece(*pieceNameOpt, color, mask);
-      }
-    }
+Board::Board() {
+  engine_.setNetwork(chess::nnue::loadDefaultNetwork());
+  engine_.setProgressCallback(
+      [this](const chess::search::IterationInfo &info) {
+        if (!pondering_.load(std::memory_order_relaxed))
+          printSearchInfo(info);
+      });
+}
+
+Move Board::getEngineMove(const int depth) {
+  const bool isPonderHit = ponderHash_ == boardState_.getHash();
+  ponderHash_.reset();
+
+  // On a hit the pondering search just carries on to the requested depth,
+  // now reporting its progress; otherwise it is replaced by a fresh one.
+  pondering_.store(false, std::memory_order_relaxed);
+  chess::search::SearchResult result;
+  if (isPonderHit) {
+    std::cout << "ponder hit" << std::endl;
+    result = ponderResult_.get();
+  } else {
+    result =
+        engine_.start(boardState_, positionHistory_, {.depth = depth}).get();
   }
+  principalVariation_ = result.principalVariation;
+  printSearchSummary(result);
+  return result.bestMove;
 }
 
-} // namespace
+void Board::startPondering(const int depth) {
+  // The second move of the principal variation is the reply we expect.
+  if (principalVariation_.size() < 2)
+    return;
+
+  BoardState ponderState = boardState_;
+  chess::move_executor::doMove(ponderState, principalVariation_[1]);
+  std::vector<uint64_t> ponderHistory = positionHistory_;
+  ponderHistory.push_back(ponderState.getHash());
 
-std::vector<Move> Board::getAndPrintPossibleMoves() const {
-  const std::vector<Move> possibleMoves =
-      chess_move_generator::getPossibleMoves(boardState_);
-  for (const auto &move : possibleMoves) {
-    std::cout << move.getMoveString() << "\n";
+  pondering_.store(true, std::memory_order_relaxed);
+  ponderHash_ = ponderState.getHash();
+  ponderResult_ =
+      engine_.start(ponderState, ponderHistory, {.depth = depth});
+}
+
+void Board::printSearchInfo(const chess::search::IterationInfo &info) const {
+  const long long milliseconds = info.elapsed.count();
+  std::cout << "depth " << info.depth;
+  if constexpr (chess::search::SEARCH_STATS_ENABLED)
+    std::cout << " seldepth " << info.stats.selectiveDepth;
+  std::cout << " score " << info.score << " nodes " << info.nodes << " nps "
+            << (milliseconds > 0 ? info.nodes * 1000 / milliseconds
+                                 : info.nodes)
+            << " pv";
+  std::array<char, chess::notation::MAX_UCI_LENGTH> buffer;
+  for (const Move &move : info.principalVariation) {
+    const auto result = chess::notation::toUci(
+        buffer.data(), buffer.data() + buffer.size(), move);
+    std::cout << ' '
+              << std::string_view(buffer.data(), result.ptr - buffer.data());
   }
   std::cout << std::endl;
-  return possibleMoves;
 }
 
-Move Board::getEngineMove(const int depth) {
-  return minimax({.depth = depth,
-                  .alpha = -std::numeric_limits<float>::infinity(),
-                  .beta = std::numeric_limits<float>::infinity(),
-                  .isRootCall = true})
-      .bestMove;
+void Board::printSearchSummary(
+    const chess::search::SearchResult &result) const {
+  if constexpr (!chess::search::SEARCH_STATS_ENABLED)
+    return;
+
+  const chess::search::SearchStats &stats = result.stats;
+  std::cout << std::fixed << std::setprecision(1) << "nodes " << result.nodes
+            << " qnodes " << stats.quiescenceNodes << " seldepth "
+            << stats.selectiveDepth << "\ncutoffs " << stats.betaCutoffs
+            << " first move " << 100.0 * stats.firstMoveCutoffRate()
+            << "%\ntt probes " << stats.ttProbes << " hits "
+            << 100.0 * stats.ttHitRate() << "% cutoffs " << stats.ttCutoffs
+            << "\npawn hash hits " << 100.0 * stats.pawnHitRate()
+            << "% eval cache hits " << 100.0 * stats.evalCacheHitRate()
+            << "%\nnull move " << stats.nullMoveCutoffs << "/"
+            << stats.nullMoveTries << " lmr re-searches "
+            << stats.lmrResearches << "/" << stats.lmrReductions
+            << std::defaultfloat << std::endl;
 }
 
-void Board::handleTurn(const chess_input::GameParams &inputs) {
+const std::vector<Move> &Board::getPrincipalVariation() const {
+  return principalVariation_;
+}
+
+void Board::setSelectivityParams(
+    const chess::search::SelectivityParams &params) {
+  engine_.setSelectivityParams(params);
+}
+
+void Board::setHelperThreadCount(const size_t count) {
+  engine_.setHelperThreadCount(count);
+}
+
+void Board::setHashSize(const size_t megabytes) {
+  engine_.setHashSize(megabytes);
+}
+
+void Board::handleTurn(const chess::input::GameParams &inputs) {
   const bool isPlayerMove =
-      inputs.opponentType == chess_input::OpponentType::HUMAN ||
-      (inputs.opponentType == chess_input::OpponentType::ENGINE &&
+      inputs.opponentType == chess::input::OpponentType::HUMAN ||
+      (inputs.opponentType == chess::input::OpponentType::ENGINE &&
        (boardState_.getTurnColor() == inputs.playerColor));
 
-  Move move = isPlayerMove
-                  ? chess_input::getPlayerMove(getAndPrintPossibleMoves())
-                  : getEngineMove(inputs.depth);
+  Move move;
+  if (isPlayerMove) {
+    printLegalMoves();
+    move = chess::input::getPlayerMove(boardState_);
+  } else {
+    move = getEngineMove(inputs.depth);
+  }
 
-  chess_move_executor::doMove(boardState_, move);
+  chess::move_executor::doMove(boardState_, move);
+  positionHistory_.push_back(boardState_.getHash());
   printBoard(boardState_);
-  boardState_.swapTurnColor();
+
+  if (!isPlayerMove && inputs.ponder)
+    startPondering(inputs.depth);
 }
 
-void Board::startGame() {
-  const chess_input::GameParams inputs = chess_input::gatherInputs();
+void Board::startGame(const chess::input::GameParams &inputs) {
+  setHelperThreadCount(inputs.helperThreads);
 
-  initPieces(boardState_);
+  boardState_ = *parseFen(START_FEN);
+  positionHistory_.assign(1, boardState_.getHash());
   printBoard(boardState_);
 
-  while (true || !isGameOver(boardState_.getTurnColor())) {
+  while (!isGameOver(boardState_.getTurnColor()))
     handleTurn(inputs);
-  }
 
-  std::cout << isCheckmate(Color::BLACK) ? "White wins!"
-  : isCheckmate(Color::WHITE)            ? "Black wins!"
-                                         : "It's a tie!";
+  // Only the side to move can have been mated.
+  const Color turnColor = boardState_.getTurnColor();
+  std::cout << (!isCheckmate(turnColor)       ? "It's a tie!"
+                : turnColor == Color::BLACK ? "White wins!"
+                                            : "Black wins!")
+            << std::endl;
 }
 
 void Board::printBoard(BoardState &boardState) {
@@ -126,10 +215,10 @@ void Board::printBoard(BoardState &boardState) {
   };
 
   for (std::uint8_t rank = 0; rank < 8; ++rank) {
-    std::cout << std::left << std::setw(3) << (7 - rank);
+    std::cout << std::left << std::setw(3) << (8 - rank);
 
     for (std::uint8_t file = 0; file < 8; ++file) {
-      const chess_board::Bitboard mask = 1ULL << (rank * 8 + file);
+      const chess::board::Bitboard mask = 1ULL << (rank * 8 + file);
       std::cout << std::setw(2) << getPieceAtMask(mask);
 
       if (file == 7)
@@ -137,72 +226,11 @@ void Board::printBoard(BoardState &boardState) {
     }
   }
 
-  std::cout << "\n   0 1 2 3 4 5 6 7\n" << std::endl;
-}
-
-Board::MinimaxResult Board::minimax(const MinimaxParams &params) {
-  const auto &[depth, alpha, beta, isRootCall] = params;
-
-  const Color turnColor = boardState_.getTurnColor();
-
-  if (depth == 0 || isGameOver(turnColor))
-    return {evaluate(turnColor, depth), {}};
-
-  Move bestMove{};
-  float bestScore = turnColor == Color::WHITE
-                        ? std::numeric_limits<float>::lowest()
-                        : std::numeric_limits<float>::max();
-
-  for (const Move &move : chess_move_generator::getPossibleMoves(boardState_)) {
-    BoardState pieceCopy = boardState_;
-    boardState_.swapTurnColor();
-
-    chess_move_executor::doMove(boardState_, move);
-    if (isChecked(turnColor)) {
-      boardState_ = pieceCopy;
-      continue;
-    }
-
-    float score = minimax({depth - 1, alpha, beta, false}).score;
-
-    boardState_ = pieceCopy;
-    boardState_.swapTurnColor();
-
-    if (turnColor == Color::WHITE ? score > bestScore : score < bestScore) {
-      bestScore = score;
-      if (isRootCall)
-        bestMove = move;
-    }
-
-    const bool branchToPrune =
-        (turnColor == Color::WHITE && bestScore >= beta) ||
-        (turnColor == Color::BLACK && bestScore <= alpha);
-    if (branchToPrune)
-      break;
-  }
-  return {bestScore, bestMove};
-}
-
-float Board::evaluate(const Color color, const std::size_t depth) {
-  static constexpr float CHECKMATE_SCORE = 1000.0f;
-
-  if (isCheckmate(Color::WHITE))
-    return CHECKMATE_SCORE + depth; // add depth to prioritize faster mates
-
-  if (isCheckmate(Color::BLACK))
-    return -CHECKMATE_SCORE - depth;
-
-  if (isStalemate(Color::WHITE) || isStalemate(Color::BLACK))
-    return 0.0f;
-
-  return boardState_.materialScore() + boardState_.positionScore();
+  std::cout << "\n   a b c d e f g h\n" << std::endl;
 }
 
 bool Board::isChecked(const Color color) const {
-  const Bitboard king = color == Color::WHITE
-                            ? boardState_.getPieces(Color::WHITE, Name::KING)
-                            : boardState_.getPieces(Color::BLACK, Name::KING);
-  return king & chess_move_generator::getThreatSquares(color, boardState_);
+  return chess::move_generator::isInCheck(color, boardState_);
 }
 
 bool Board::isCheckmate(const Color color) {
@@ -214,16 +242,31 @@ bool Board::isStalemate(const Color color) {
          boardState_.onlyKingsLeft();
 }
 
+// Moves are only generated for the side to move, so `color` must be it.
 bool Board::isGameOver(const Color color) {
-  return isCheckmate(Color::WHITE) || isCheckmate(Color::BLACK) ||
-         isStalemate(Color::WHITE) || isStalemate(Color::BLACK) ||
-         boardState_.onlyKingsLeft();
+  return isCheckmate(color) || isStalemate(color) || isDrawByRule();
+}
+
+bool Board::isDrawByRule() const {
+  if (chess::search::isFiftyMoveDraw(boardState_))
+    return true;
+
+  // Threefold repetition; only positions since the last irreversible move
+  // can match the current one.
+  const uint64_t hash = boardState_.getHash();
+  const size_t window = std::min<size_t>(boardState_.getHalfmoveClock(),
+                                         positionHistory_.size() - 1);
+  int occurrences = 1;
+  for (size_t back = 2; back <= window; back += 2)
+    if (positionHistory_[positionHistory_.size() - 1 - back] == hash)
+      ++occurrences;
+  return occurrences >= 3;
 }
 
 bool Board::hasLegalMoves(const Color color) {
-  for (const Move &move : chess_move_generator::getPossibleMoves(boardState_)) {
+  for (const Move &move : chess::move_generator::getPossibleMoves(boardState_)) {
     BoardState pieceCopy = boardState_;
-    chess_move_executor::doMove(boardState_, move);
+    chess::move_executor::doMove(boardState_, move);
     if (!isChecked(color)) {
       boardState_ = pieceCopy;
       return true;
@@ -233,4 +276,4 @@ bool Board::hasLegalMoves(const Color color) {
   return false;
 }
 
-} // namespace chess_board
\ No newline at end of file
+} // namespace chess::board
\ No newline at end of file
@@ -4,7 +4,15 @@ import chess.core;
 import chess.board_state;
 import chess.move;
 import chess.input;
+import chess.search;
+import chess.engine;
+import chess.search_stats;
+import chess.repetition;
+import <atomic>;
+import <cstddef>;
 import <cstdint>;
+import <future>;
+import <optional>;
 import <vector>;
 
 export module chess.board;
@@ -13,34 +21,38 @@ export namespace chess::board {
 
 export class Board {
 private:
-  struct MinimaxParams {
-    int depth;
-    float alpha, beta;
-    bool isRootCall;
-  };
-
-  struct MinimaxResult {
-    float score;
-    Move bestMove;
-  };
-
   BoardState boardState_{};
-
-  std::vector<Move> getAndPrintPossibleMoves() const;
+  chess::engine::Engine engine_;
+  std::vector<Move> principalVariation_;
+  std::vector<uint64_t> positionHistory_; // hashes of every position played
+  // The pondering search, if any, and the position it is on.
+  std::future<chess::search::SearchResult> ponderResult_;
+  std::optional<uint64_t> ponderHash_;
+  std::atomic<bool> pondering_{false}; // mutes its iteration output
+
+  void printLegalMoves() const;
   Move getEngineMove(const int depth);
+  void startPondering(const int depth);
+  void printSearchInfo(const chess::search::IterationInfo &info) const;
+  void printSearchSummary(const chess::search::SearchResult &result) const;
   void handleTurn(const chess::input::GameParams &inputs);
 
-  MinimaxResult minimax(const MinimaxParams &params);
   bool isChecked(const Color color) const;
   bool isCheckmate(const Color color);
   bool isStalemate(const Color color);
   bool isGameOver(const Color color);
+  bool isDrawByRule() const;
   bool hasLegalMoves(const Color color);
-  float evaluate(const Color color, const uint8_t depth);
 
 public:
-  void startGame();
+  Board();
+
+  void startGame(const chess::input::GameParams &inputs);
   static void printBoard(BoardState &boardState_);
+  const std::vector<Move> &getPrincipalVariation() const;
+  void setSelectivityParams(const chess::search::SelectivityParams &params);
+  void setHelperThreadCount(const size_t count);
+  void setHashSize(const size_t megabytes);
 };
 
 } // namespace chess::board
\ No newline at end of file
@@ -1,6 +1,8 @@
 module;
 
 import chess.core;
+import chess.score;
+import chess.zobrist;
 import <array>;
 import <bit>;
 import <numeric>;
@@ -22,14 +24,28 @@ export struct BoardState {
          blackLong = true;
   } castles_{};
 
-  struct PieceInfo {
-    Bitboard *board;
+  // The piece on a square and the bitboard it is on, writable through
+  // PieceInfo only.
+  template <typename BitboardPointer> struct BasicPieceInfo {
+    BitboardPointer board;
     Name name;
     Color color;
   };
+  using PieceInfo = BasicPieceInfo<Bitboard *>;
+  using ConstPieceInfo = BasicPieceInfo<const Bitboard *>;
 
   std::optional<Bitboard> enPassantSquare_;
   Color turnColor_ = Color::WHITE;
+  // Zobrist hash, kept up to date by every mutator below, and the same over
+  // the pawns alone.
+  uint64_t hash_ = 0;
+  uint64_t pawnHash_ = 0;
+  // Plies since the last capture or pawn move.
+  uint16_t halfmoveClock_ = 0;
+  // Sum of the piece-square scores of every piece (white's advantage) and
+  // of their phase weights, kept up to date alongside the hash.
+  Score pieceSquareScore_ = 0;
+  int phase_ = 0;
 
   [[nodiscard]] constexpr Bitboard getPieces(Color color, Name name) const {
     return colorPieces_[static_cast<size_t>(color)]
@@ -66,86 +82,51 @@ export struct BoardState {
                            getPieces(Color::BLACK, Name::KING));
   }
 
-  [[nodiscard]] std::optional<BoardState::PieceInfo>
-  getPieceInfo(const Bitboard square) {
+  // Shared by both getPieceInfo overloads; `Self` is BoardState, const or
+  // not.
+  template <typename Info, typename Self>
+  [[nodiscard]] static std::optional<Info> findPiece(Self &self,
+                                                     const Bitboard square) {
     for (size_t colorIndex = 0; colorIndex < 2; ++colorIndex) {
       Color color = static_cast<Color>(colorIndex);
       for (size_t nameIndex = 0; nameIndex < static_cast<size_t>(Name::COUNT);
            ++nameIndex) {
         Name name = static_cast<Name>(nameIndex);
-        if (square & colorPieces_[colorIndex].pieces[nameIndex]) {
-          Bitboard *actualBoardPtr =
-              &colorPieces_[colorIndex].pieces[nameIndex];
-          return PieceInfo{actualBoardPtr, name, color};
-        }
+        if (square & self.colorPieces_[colorIndex].pieces[nameIndex])
+          return Info{&self.colorPieces_[colorIndex].pieces[nameIndex], name,
+                      color};
       }
     }
     return std::nullopt;
   }
 
+  [[nodiscard]] std::optional<PieceInfo> getPieceInfo(const Bitboard square) {
+    return findPiece<PieceInfo>(*this, square);
+  }
+
+  [[nodiscard]] std::optional<ConstPieceInfo>
+  getPieceInfo(const Bitboard square) const {
+    return findPiece<ConstPieceInfo>(*this, square);
+  }
+
   [[nodiscard]] constexpr Color getTurnColor() const { return turnColor_; }
 
-  [[nodiscard]] constexpr int materialScore() const {
-    return 1 * std::popcount(getPieces(Color::WHITE, Name::PAWN)) +
-           3 * std::popcount(getPieces(Color::WHITE, Name::KNIGHT) |
-                             getPieces(Color::WHITE, Name::BISHOP)) +
-           5 * std::popcount(getPieces(Color::WHITE, Name::ROOK)) +
-           9 * std::popcount(getPieces(Color::WHITE, Name::QUEEN)) -
-           1 * std::popcount(getPieces(Color::BLACK, Name::PAWN)) -
-           3 * std::popcount(getPieces(Color::BLACK, Name::KNIGHT) |
-                             getPieces(Color::BLACK, Name::BISHOP)) -
-           5 * std::popcount(getPieces(Color::BLACK, Name::ROOK)) -
-           9 * std::popcount(getPieces(Color::BLACK, Name::QUEEN));
-  }
-
-  [[nodiscard]] constexpr float positionScore() const {
-    constexpr float PIECE_LOCATION_VALUES[8][8]{
-        {-.5f, -.4f, -.4f, -.4f, -.4f, -.4f, -.4f, -.5f},
-        {-.4f, -.2f, .0f, .0f, .0f, .0f, -.2f, -.4f},
-        {-.4f, .0f, .1f, .2f, .2f, .1f, .0f, -.4f},
-        {-.4f, .0f, .2f, .25f, .25f, .2f, .0f, -.4f},
-        {-.4f, .0f, .2f, .25f, .25f, .2f, .0f, -.4f},
-        {-.4f, .0f, .1f, .2f, .2f, .1f, .0f, -.4f},
-        {-.4f, -.2f, .0f, .0f, .0f, .0f, -.2f, -.4f},
-        {-.5f, -.4f, -.4f, -.4f, -.4f, -.4f, -.4f, -.5f}};
-    constexpr float KING_LOCATION_VALUES[8][8]{
-        {-.3f, -.4f, -.4f, -.5f, -.5f, -.4f, -.4f, -.3f},
-        {-.3f, -.4f, -.4f, -.5f, -.5f, -.4f, -.4f, -.3f},
-        {-.3f, -.4f, -.4f, -.5f, -.5f, -.4f, -.4f, -.3f},
-        {-.3f, -.4f, -.4f, -.5f, -.5f, -.4f, -.4f, -.3f},
-        {-.3f, -.4f, -.4f, -.5f, -.5f, -.4f, -.4f, -.3f},
-        {-.2f, -.2f, -.2f, -.2f, -.2f, -.2f, -.2f, -.2f},
-        {.2f, .2f, .0f, .0f, .0f, .0f, .2f, .2f},
-        {.2f, .3f, .1f, .0f, .0f, .1f, .3f, .2f}};
-
-    auto processPieces = [&](Bitboard bb, const Color color,
-                             const bool isKing) -> float {
-      const float multiplier = color == Color::WHITE ? 1.0f : -1.0f;
-      float localScore = 0.0f;
-
-      while (auto pieceInfo = getNextPiece(bb)) {
-        const std::uint8_t index = pieceInfo->index;
-
-        std::uint8_t lookup_row = index / 8,
-                     lookup_file =
-                         (color == Color::WHITE) ? index % 8 : 7 - index % 8;
-
-        localScore += (isKing ? KING_LOCATION_VALUES[lookup_row][lookup_file]
-                              : PIECE_LOCATION_VALUES[lookup_row][lookup_file]);
-      }
-      return localScore * multiplier;
-    };
+  [[nodiscard]] constexpr uint64_t getHash() const { return hash_; }
+
+  [[nodiscard]] constexpr uint64_t getPawnHash() const { return pawnHash_; }
+
+  [[nodiscard]] constexpr uint16_t getHalfmoveClock() const {
+    return halfmoveClock_;
+  }
 
-    return processPieces(getPieces(Color::WHITE) &
-                             ~getPieces(Color::WHITE, Name::KING),
-                         Color::WHITE, false) +
-           processPieces(getPieces(Color::BLACK) &
-                             ~getPieces(Color::BLACK, Name::KING),
-                         Color::BLACK, false) +
-           processPieces(getPieces(Color::WHITE, Name::KING), Color::WHITE,
-                         true) +
-           processPieces(getPieces(Color::BLACK, Name::KING), Color::BLACK,
-                         true);
+  [[nodiscard]] constexpr Score getPieceSquareScore() const {
+    return pieceSquareScore_;
+  }
+
+  // From MAX_PHASE in the opening down to 0 in a pawn ending; extra
+  // promoted pieces do not push it past the opening.
+  [[nodiscard]] constexpr int getPhase() const {
+    return phase_ < MAX_PHASE ? phase_ : MAX_PHASE;
   }
 
   // Methods for board manipulation
@@ -153,6 +134,18 @@ export struct BoardState {
   bool tryMovePiece(Bitboard from, Bitboard to) {
     if (auto pieceInfo = getPieceInfo(from)) {
       *pieceInfo->board ^= (from | to);
+      const uint64_t keys = getPieceKey(pieceInfo->color, pieceInfo->name,
+                                        std::countr_zero(from)) ^
+                            getPieceKey(pieceInfo->color, pieceInfo->name,
+                                        std::countr_zero(to));
+      hash_ ^= keys;
+      if (pieceInfo->name == Name::PAWN)
+        pawnHash_ ^= keys;
+      pieceSquareScore_ +=
+          chess::board::getPieceSquareScore(pieceInfo->color, pieceInfo->name,
+                                            std::countr_zero(to)) -
+          chess::board::getPieceSquareScore(pieceInfo->color, pieceInfo->name,
+                                            std::countr_zero(from));
       return true;
     }
     return false;
@@ -161,41 +154,78 @@ export struct BoardState {
   bool tryRemovePiece(Bitboard square) {
     if (auto pieceInfo = getPieceInfo(square)) {
       *pieceInfo->board &= ~square;
+      const uint64_t key = getPieceKey(pieceInfo->color, pieceInfo->name,
+                                       std::countr_zero(square));
+      hash_ ^= key;
+      if (pieceInfo->name == Name::PAWN)
+        pawnHash_ ^= key;
+      pieceSquareScore_ -= chess::board::getPieceSquareScore(
+          pieceInfo->color, pieceInfo->name, std::countr_zero(square));
+      phase_ -= PHASE_WEIGHTS[static_cast<size_t>(pieceInfo->name)];
       return true;
     }
     return false;
   }
 
   void addPiece(Name name, Color color, Bitboard square) {
+    Bitboard added = square & ~getPieces(color, name);
     colorPieces_[static_cast<size_t>(color)]
         .pieces[static_cast<size_t>(name)] |= square;
+    while (auto pieceInfo = getNextPiece(added)) {
+      const uint64_t key = getPieceKey(color, name, pieceInfo->index);
+      hash_ ^= key;
+      if (name == Name::PAWN)
+        pawnHash_ ^= key;
+      pieceSquareScore_ +=
+          chess::board::getPieceSquareScore(color, name, pieceInfo->index);
+      phase_ += PHASE_WEIGHTS[static_cast<size_t>(name)];
+    }
   }
 
   void setEnPassantSquare(std::optional<Bitboard> square) {
+    if (enPassantSquare_)
+      hash_ ^= ZOBRIST_KEYS.enPassantFile[std::countr_zero(*enPassantSquare_) %
+                                          8];
+    if (square)
+      hash_ ^= ZOBRIST_KEYS.enPassantFile[std::countr_zero(*square) % 8];
     enPassantSquare_ = square;
   }
 
   void updateCastlingRights(Color color, bool shortCastleLost,
                             bool longCastleLost) {
+    // The hash carries the key of every right already lost.
+    auto loseRight = [&](bool &right, const size_t keyIndex) {
+      if (right)
+        hash_ ^= ZOBRIST_KEYS.castling[keyIndex];
+      right = false;
+    };
+
     if (color == Color::WHITE) {
       if (shortCastleLost) {
-        castles_.whiteShort = false;
+        loseRight(castles_.whiteShort, 0);
       }
       if (longCastleLost) {
-        castles_.whiteLong = false;
+        loseRight(castles_.whiteLong, 1);
       }
     } else { // color == Color::BLACK
       if (shortCastleLost) {
-        castles_.blackShort = false;
+        loseRight(castles_.blackShort, 2);
       }
       if (longCastleLost) {
-        castles_.blackLong = false;
+        loseRight(castles_.blackLong, 3);
       }
     }
   }
 
+  void resetHalfmoveClock() { halfmoveClock_ = 0; }
+
+  void setHalfmoveClock(uint16_t clock) { halfmoveClock_ = clock; }
+
+  void incrementHalfmoveClock() { ++halfmoveClock_; }
+
   void swapTurnColor() {
     turnColor_ = turnColor_ == Color::WHITE ? Color::BLACK : Color::WHITE;
+    hash_ ^= ZOBRIST_KEYS.blackToMove;
   }
 };
 
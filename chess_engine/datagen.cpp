@@ -0,0 +1,475 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+module chess.datagen;
+
+import chess.core;
+import chess.board_state;
+import chess.move;
+import chess.move_executor;
+import chess.move_generator;
+import chess.generator_helpers;
+import chess.repetition;
+import chess.nnue;
+import chess.search;
+import chess.selfplay;
+import chess.engine;
+
+namespace chess::datagen {
+
+using chess::board::Bitboard;
+using chess::board::BoardState;
+using chess::board::Color;
+using chess::board::Move;
+using chess::board::MoveList;
+using chess::board::Name;
+
+namespace {
+
+#pragma region encoding
+template <typename T> void appendValue(std::vector<char> &out, const T value) {
+  for (size_t byte = 0; byte < sizeof(T); ++byte)
+    out.push_back(static_cast<char>(
+        static_cast<std::make_unsigned_t<T>>(value) >> (8 * byte)));
+}
+
+template <typename T> T readValue(const char *data) {
+  std::make_unsigned_t<T> value = 0;
+  for (size_t byte = 0; byte < sizeof(T); ++byte)
+    value |= static_cast<std::make_unsigned_t<T>>(
+        static_cast<std::make_unsigned_t<T>>(
+            static_cast<unsigned char>(data[byte]))
+        << (8 * byte));
+  return static_cast<T>(value);
+}
+
+constexpr uint8_t NO_EN_PASSANT = 0xFF;
+
+void encodeGameHeader(std::vector<char> &out, const BoardState &start,
+                      const uint8_t result, const uint16_t plies) {
+  const Bitboard occupied = ~start.getEmpty();
+  appendValue(out, occupied);
+
+  std::array<uint8_t, 16> pieces{};
+  Bitboard remaining = occupied;
+  for (size_t slot = 0; auto square = chess::board::getNextPiece(remaining);
+       ++slot) {
+    for (size_t color = 0; color < 2; ++color) {
+      for (size_t name = 0; name < static_cast<size_t>(Name::COUNT); ++name) {
+        if (start.getPieces(static_cast<Color>(color), static_cast<Name>(name)) &
+            square->board)
+          pieces[slot / 2] |=
+              static_cast<uint8_t>((color << 3 | name) << (slot % 2 * 4));
+      }
+    }
+  }
+  out.insert(out.end(), pieces.begin(), pieces.end());
+
+  const BoardState::Castles &castles = start.castles_;
+  out.push_back(static_cast<char>(
+      (start.getTurnColor() == Color::BLACK) | castles.whiteShort << 1 |
+      castles.whiteLong << 2 | castles.blackShort << 3 |
+      castles.blackLong << 4));
+  const std::optional<Bitboard> enPassant = start.getEnPassantSquare();
+  out.push_back(static_cast<char>(
+      enPassant ? std::countr_zero(*enPassant) : NO_EN_PASSANT));
+  out.push_back(static_cast<char>(
+      std::min<uint16_t>(start.getHalfmoveClock(), UINT8_MAX)));
+  out.push_back(static_cast<char>(result));
+  appendValue(out, plies);
+}
+
+// False if the header could not have been written by encodeGameHeader.
+bool decodeGameHeader(const char *data, BoardState &start, uint8_t &result,
+                    uint16_t &plies) {
+  start = BoardState{};
+  Bitboard remaining = readValue<uint64_t>(data);
+  if (std::popcount(remaining) > 32)
+    return false;
+  for (size_t slot = 0; auto square = chess::board::getNextPiece(remaining);
+       ++slot) {
+    const uint8_t piece = static_cast<uint8_t>(data[8 + slot / 2]) >>
+                              (slot % 2 * 4) &
+                          0xF;
+    if ((piece & 7) >= static_cast<uint8_t>(Name::COUNT))
+      return false;
+    start.addPiece(static_cast<Name>(piece & 7), static_cast<Color>(piece >> 3),
+                   square->board);
+  }
+
+  const uint8_t flags = static_cast<uint8_t>(data[24]);
+  if (flags & 1)
+    start.swapTurnColor();
+  start.updateCastlingRights(Color::WHITE, !(flags & 2), !(flags & 4));
+  start.updateCastlingRights(Color::BLACK, !(flags & 8), !(flags & 16));
+  const uint8_t enPassant = static_cast<uint8_t>(data[25]);
+  if (enPassant < 64)
+    start.setEnPassantSquare(1ULL << enPassant);
+  else if (enPassant != NO_EN_PASSANT)
+    return false;
+  start.setHalfmoveClock(static_cast<uint8_t>(data[26]));
+  result = static_cast<uint8_t>(data[27]);
+  plies = readValue<uint16_t>(data + 28);
+  return result <= 2;
+}
+#pragma endregion
+
+#pragma region generation
+struct GameRecord {
+  std::vector<char> bytes;
+  uint64_t labelled = 0;
+};
+
+// Finished games on their way from the workers to the single writer.
+// Workers wait while it is full, so a slow disk holds them back instead of
+// letting games pile up in memory.
+class GameQueue {
+private:
+  std::mutex mutex_;
+  std::condition_variable notFull_, notEmpty_;
+  std::deque<GameRecord> games_;
+  size_t capacity_;
+  bool closed_ = false;
+
+public:
+  explicit GameQueue(const size_t capacity)
+      : capacity_(std::max<size_t>(1, capacity)) {}
+
+  void push(GameRecord game) {
+    std::unique_lock lock(mutex_);
+    notFull_.wait(lock, [this] { return games_.size() < capacity_; });
+    games_.push_back(std::move(game));
+    notEmpty_.notify_one();
+  }
+
+  // Waits for the next game; false once the queue is closed and empty.
+  bool pop(GameRecord &game) {
+    std::unique_lock lock(mutex_);
+    notEmpty_.wait(lock, [this] { return !games_.empty() || closed_; });
+    if (games_.empty())
+      return false;
+    game = std::move(games_.front());
+    games_.pop_front();
+    notFull_.notify_one();
+    return true;
+  }
+
+  void close() {
+    std::lock_guard lock(mutex_);
+    closed_ = true;
+    notEmpty_.notify_all();
+  }
+};
+
+// Whether the search score of a position says something the evaluation can
+// learn: not while in check, nor when the best move wins material the
+// static evaluation cannot see yet, nor for a forced mate.
+bool isTrainingPosition(const BoardState &position, const Move &bestMove,
+                        const int score) {
+  return !chess::move_generator::isInCheck(position.getTurnColor(),
+                                           position) &&
+         !chess::move_generator::isCapture(position, bestMove) &&
+         !bestMove.isPromotion() &&
+         std::abs(score) < chess::search::CHECKMATE_SCORE -
+                               chess::search::MAX_PLY;
+}
+
+// Plays one game from `start` and encodes it, or returns nothing if the
+// engine produced an illegal move.
+std::optional<GameRecord> playGame(const BoardState &start,
+                                   chess::engine::Engine &engine,
+                                   const DatagenOptions &options,
+                                   const chess::search::SearchLimits &limits) {
+  BoardState position = start;
+  std::vector<uint64_t> history{position.getHash()};
+  std::vector<std::pair<Move, int16_t>> plies;
+  engine.clearHash();
+
+  const int maxPly = std::min(options.maxPly, int{UINT16_MAX});
+  uint8_t result = 1;
+  chess::selfplay::Adjudicator adjudicator(options.adjudication);
+  MoveList legalMoves;
+  for (int ply = 0;; ++ply) {
+    const Color turnColor = position.getTurnColor();
+    chess::move_generator::getLegalMoves(position, legalMoves);
+    if (legalMoves.empty()) {
+      if (chess::move_generator::isInCheck(turnColor, position))
+        result = turnColor == Color::WHITE ? 0 : 2;
+      break;
+    }
+    if (chess::search::isFiftyMoveDraw(position) ||
+        chess::search::isRepetition(history, position.getHalfmoveClock(), 0) ||
+        chess::search::hasInsufficientMaterial(position) || ply >= maxPly)
+      break;
+
+    const chess::search::SearchResult searched =
+        engine.search(position, history, limits);
+    if (std::find(legalMoves.begin(), legalMoves.end(), searched.bestMove) ==
+        legalMoves.end())
+      return std::nullopt;
+
+    plies.emplace_back(
+        searched.bestMove,
+        isTrainingPosition(position, searched.bestMove, searched.score)
+            ? static_cast<int16_t>(
+                  std::clamp(searched.score, INT16_MIN + 1, INT16_MAX))
+            : NO_SCORE);
+
+    adjudicator.addScore(ply, turnColor == Color::WHITE ? searched.score
+                                                        : -searched.score);
+
+    chess::move_executor::doMove(position, searched.bestMove);
+    history.push_back(position.getHash());
+
+    using chess::selfplay::Verdict;
+    const Verdict verdict = adjudicator.getVerdict();
+    if (verdict != Verdict::NONE) {
+      result = verdict == Verdict::WHITE_WINS   ? 2
+               : verdict == Verdict::BLACK_WINS ? 0
+                                                : 1;
+      break;
+    }
+  }
+
+  GameRecord record;
+  record.bytes.reserve(GAME_HEADER_SIZE + plies.size() * PLY_SIZE);
+  encodeGameHeader(record.bytes, start, result,
+                   static_cast<uint16_t>(plies.size()));
+  for (const auto &[move, score] : plies) {
+    appendValue(record.bytes, move.data_);
+    appendValue(record.bytes, score);
+    record.labelled += score != NO_SCORE;
+  }
+  return record;
+}
+#pragma endregion
+
+} // namespace
+
+#pragma region reader
+TrainingDataReader::TrainingDataReader(const std::string &path)
+    : file_(path, std::ios::binary), path_(path) {
+  if (!file_)
+    throw std::logic_error("Cannot open training data " + path);
+  std::array<char, DATA_HEADER_SIZE> header;
+  if (!file_.read(header.data(), header.size()) ||
+      std::memcmp(header.data(), DATA_MAGIC.data(), DATA_MAGIC.size()) != 0 ||
+      readValue<uint32_t>(header.data() + 4) != DATA_VERSION)
+    throw std::logic_error("Not training data of this engine: " + path);
+}
+
+bool TrainingDataReader::readGameHeader() {
+  std::array<char, GAME_HEADER_SIZE> header;
+  if (!file_.read(header.data(), header.size()))
+    return false;
+  if (!decodeGameHeader(header.data(), position_, result_,
+                                      pliesLeft_))
+    throw std::logic_error("Corrupt training data in " + path_);
+  return true;
+}
+
+bool TrainingDataReader::next(TrainingPosition &entry) {
+  std::array<char, PLY_SIZE> ply;
+  while (true) {
+    while (!pliesLeft_) {
+      if (!readGameHeader())
+        return false;
+    }
+    if (!file_.read(ply.data(), ply.size())) {
+      pliesLeft_ = 0;
+      return false;
+    }
+    --pliesLeft_;
+
+    Move move;
+    move.data_ = readValue<uint16_t>(ply.data());
+    const int16_t score = readValue<int16_t>(ply.data() + 2);
+    const bool labelled = score != NO_SCORE;
+    if (labelled)
+      entry = {position_, score, result_};
+    chess::move_executor::doMove(position_, move);
+    if (labelled)
+      return true;
+  }
+}
+
+auto isTrainingDataFile(const std::string &path) -> bool {
+  std::ifstream file(path, std::ios::binary);
+  std::array<char, 4> magic{};
+  return file.read(magic.data(), magic.size()) &&
+         std::string_view(magic.data(), magic.size()) == DATA_MAGIC;
+}
+#pragma endregion
+
+void runDatagen(std::ostream &out, const DatagenOptions &options) {
+  const unsigned threads =
+      options.threads ? options.threads
+                      : std::max(1U, std::thread::hardware_concurrency());
+  chess::search::SearchLimits limits{.depth = chess::search::MAX_PLY - 1,
+                                     .nodes = options.nodes};
+  if (options.depth > 0)
+    limits.depth = std::min(options.depth, limits.depth);
+  if (!options.depth && !options.nodes)
+    limits.nodes = DEFAULT_DATAGEN_NODES;
+
+  std::shared_ptr<const chess::nnue::Network> network;
+  if (!options.networkFile.empty())
+    network = chess::nnue::Network::load(options.networkFile);
+
+  std::ofstream file(options.outputFile, std::ios::binary);
+  std::vector<char> header(DATA_MAGIC.begin(), DATA_MAGIC.end());
+  appendValue(header, DATA_VERSION);
+  if (!file || !file.write(header.data(), header.size()))
+    throw std::logic_error("Cannot write training data to " +
+                           options.outputFile);
+
+  out << "Writing " << options.positions << " positions to "
+      << options.outputFile << " on " << threads << " threads" << std::endl;
+
+  // Counted as games finish, so workers stop starting new ones in time.
+  std::atomic<uint64_t> labelled{0};
+  std::atomic<bool> failed{false};
+  GameQueue queue(options.queueCapacity);
+
+  const auto runWorker = [&](const unsigned worker) {
+    chess::engine::Engine engine;
+    engine.setHashSize(options.hashMegabytes);
+    engine.setNetwork(network);
+    std::mt19937_64 random(options.seed + worker);
+
+    for (uint64_t game = 0;
+         labelled.load(std::memory_order_relaxed) < options.positions &&
+         !failed.load(std::memory_order_relaxed);
+         ++game) {
+      const BoardState start =
+          chess::selfplay::makeRandomOpening(
+              options.randomPlies + static_cast<int>((worker + game) % 2),
+              random)
+              .position;
+      std::optional<GameRecord> record =
+          playGame(start, engine, options, limits);
+      if (!record)
+        continue;
+      labelled.fetch_add(record->labelled, std::memory_order_relaxed);
+      queue.push(std::move(*record));
+    }
+  };
+
+  // The only thread touching the file. After a failed write it keeps
+  // draining the queue so that no worker waits on it forever.
+  uint64_t written = 0;
+  const auto runWriter = [&] {
+    const auto startTime = std::chrono::steady_clock::now();
+    const uint64_t reportInterval =
+        std::max<uint64_t>(1, options.positions / 20);
+    uint64_t games = 0, plies = 0, bytes = header.size(),
+             nextReport = reportInterval;
+    GameRecord game;
+    while (queue.pop(game)) {
+      if (failed.load(std::memory_order_relaxed))
+        continue;
+      if (!file.write(game.bytes.data(),
+                      static_cast<std::streamsize>(game.bytes.size()))) {
+        failed.store(true, std::memory_order_relaxed);
+        continue;
+      }
+      ++games;
+      bytes += game.bytes.size();
+      plies += (game.bytes.size() - GAME_HEADER_SIZE) / PLY_SIZE;
+      written += game.labelled;
+      if (written < nextReport)
+        continue;
+      const double seconds = std::chrono::duration<double>(
+                                 std::chrono::steady_clock::now() - startTime)
+                                 .count();
+      out << "Games " << games << ", positions " << written << " of "
+          << options.positions << std::fixed << std::setprecision(0) << ", "
+          << static_cast<double>(written) / std::max(seconds, 1e-3)
+          << " per second, " << std::setprecision(1)
+          << static_cast<double>(bytes) / static_cast<double>(plies)
+          << " bytes per ply" << std::endl;
+      nextReport = (written / reportInterval + 1) * reportInterval;
+    }
+  };
+
+  std::thread writer(runWriter);
+  std::vector<std::thread> workers;
+  for (unsigned worker = 0; worker < threads; ++worker)
+    workers.emplace_back(runWorker, worker);
+  for (std::thread &worker : workers)
+    worker.join();
+  queue.close();
+  writer.join();
+
+  if (failed || !file.flush())
+    throw std::logic_error("Cannot write training data to " +
+                           options.outputFile);
+  out << "Wrote " << written << " positions to " << options.outputFile
+      << std::endl;
+}
+
+auto parseDatagenArguments(const std::span<const std::string_view> words)
+    -> DatagenOptions {
+  DatagenOptions options;
+  const auto parse = [](const std::string_view value, auto &target) {
+    std::from_chars(value.data(), value.data() + value.size(), target);
+  };
+  for (const std::string_view word : words) {
+    const size_t equals = word.find('=');
+    if (equals == std::string_view::npos)
+      continue;
+    const std::string_view key = word.substr(0, equals);
+    const std::string_view value = word.substr(equals + 1);
+    if (key == "out")
+      options.outputFile = value;
+    else if (key == "positions")
+      parse(value, options.positions);
+    else if (key == "threads")
+      parse(value, options.threads);
+    else if (key == "queue")
+      parse(value, options.queueCapacity);
+    else if (key == "depth")
+      parse(value, options.depth);
+    else if (key == "nodes")
+      parse(value, options.nodes);
+    else if (key == "evalfile")
+      options.networkFile = value;
+    else if (key == "hash")
+      parse(value, options.hashMegabytes);
+    else if (key == "plies")
+      parse(value, options.randomPlies);
+    else if (key == "seed")
+      parse(value, options.seed);
+    else if (key == "maxply")
+      parse(value, options.maxPly);
+  }
+  return options;
+}
+
+} // namespace chess::datagen
@@ -0,0 +1,117 @@
+module;
+
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+
+export module chess.datagen;
+
+import chess.board_state;
+import chess.selfplay;
+
+export namespace chess::datagen {
+
+// Training data layout, little endian. A game is stored as its first
+// position and then only the moves, so each further position costs four
+// bytes:
+//   char[4]  "CHTD"
+//   uint32   version (1)
+// then any number of games, each
+//   uint64   occupied squares, bit i for square index i
+//   uint8    [16] piece on each occupied square in index order, four bits
+//            each, low half first: color << 3 | name
+//   uint8    side to move in bit 0, castling rights KQkq in bits 1 to 4
+//   uint8    en passant square index, or 0xFF
+//   uint8    halfmove clock, at most 255
+//   uint8    result for white in half points: 0, 1 or 2
+//   uint16   ply count
+//   ply count times:
+//     uint16 move played, in chess::board::Move's encoding
+//     int16  search score of the position before it, for the side to
+//            move, or NO_SCORE if the position is not for training
+export inline constexpr std::string_view DATA_MAGIC = "CHTD";
+export inline constexpr uint32_t DATA_VERSION = 1;
+export inline constexpr size_t DATA_HEADER_SIZE = 8;
+export inline constexpr size_t GAME_HEADER_SIZE = 30;
+export inline constexpr size_t PLY_SIZE = 4;
+export inline constexpr int16_t NO_SCORE = INT16_MIN;
+
+export struct TrainingPosition {
+  chess::board::BoardState position;
+  int16_t score;  // for the side to move
+  uint8_t result; // for white, in half points
+};
+
+// Streams the labelled positions of a training data file one at a time,
+// replaying each game from its first position, so files of any size can
+// be read in constant memory.
+export class TrainingDataReader {
+private:
+  std::ifstream file_;
+  std::string path_;
+  chess::board::BoardState position_{};
+  uint8_t result_ = 0;
+  uint16_t pliesLeft_ = 0;
+
+  bool readGameHeader();
+
+public:
+  // Throws std::logic_error if the file cannot be opened or was not
+  // written by this engine.
+  explicit TrainingDataReader(const std::string &path);
+
+  // The next position with a score, or false at the end of the file. A
+  // game cut short by an interrupted writer ends the file.
+  bool next(TrainingPosition &entry);
+};
+
+// True if the file starts with the training data header.
+export auto isTrainingDataFile(const std::string &path) -> bool;
+
+// Used when no limit is given at all.
+export inline constexpr uint64_t DEFAULT_DATAGEN_NODES = 5'000;
+
+export struct DatagenOptions {
+  std::string outputFile = "training.bin";
+  // Labelled positions to write; games in progress are finished, so a few
+  // more may be.
+  uint64_t positions = 1'000'000;
+  // Every core when 0.
+  unsigned threads = 0;
+  // Finished games waiting to be written; workers wait when it is full.
+  size_t queueCapacity = 256;
+
+  // Per move, either or both.
+  int depth = 0;
+  uint64_t nodes = 0;
+  std::string networkFile;
+  size_t hashMegabytes = 16;
+
+  // Random moves before the engine takes over, one more in every other
+  // game so that both colors get to move first.
+  int randomPlies = 8;
+  uint64_t seed = 1;
+
+  // On the scores of the one engine playing both sides.
+  chess::selfplay::AdjudicationParams adjudication{};
+  int maxPly = 400;
+};
+
+// Plays the engine against itself on every thread and streams each game to
+// the output file through a bounded queue and a single writer thread,
+// reporting progress to `out`. Positions in check, or whose best move is a
+// capture or promotion, or with a mate score, are kept for replay but get
+// NO_SCORE. Throws std::logic_error if the output cannot be written.
+export void runDatagen(std::ostream &out, const DatagenOptions &options);
+
+// Reads the words after `datagen`, all of the form key=value: out,
+// positions, threads, queue, depth, nodes, evalfile, hash, plies, seed and
+// maxply. Unknown words are ignored.
+export auto parseDatagenArguments(std::span<const std::string_view> words)
+    -> DatagenOptions;
+
+} // namespace chess::datagen
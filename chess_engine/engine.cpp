@@ -0,0 +1,153 @@
+module;
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <future>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <thread>
+#include <utility>
+#include <vector>
+
+module chess.engine;
+
+import chess.board_state;
+import chess.nnue;
+import chess.search;
+import chess.trace;
+
+namespace chess::engine {
+
+using chess::board::BoardState;
+using chess::search::IterationInfo;
+using chess::search::SearchLimits;
+using chess::search::SearchPool;
+using chess::search::SearchResult;
+
+Engine::Engine(const EngineOptions &options)
+    // Under a budget the table starts with a single slot and is sized once
+    // the rest is known, so the default size is never allocated.
+    : searchPool_(options.sharedTable,
+                  options.memoryBudget != 0 ? 0
+                                            : chess::search::DEFAULT_HASH_MB),
+      memoryBudget_(options.memoryBudget) {
+  searchPool_.setHelperThreadCount(options.helperThreads);
+  applyMemoryBudget();
+}
+
+void Engine::applyMemoryBudget() {
+  if (memoryBudget_ == 0)
+    return;
+
+  if (getFixedMemoryUsage() > memoryBudget_)
+    throw std::logic_error("Memory budget too small for the search threads");
+  if (searchPool_.ownsTable())
+    searchPool_.setHashSizeInBytes(memoryBudget_ - getFixedMemoryUsage());
+}
+
+size_t Engine::getFixedMemoryUsage() const {
+  return searchPool_.getSearchMemoryUsage() +
+         searchPool_.getEvalCacheSizeInBytes();
+}
+
+std::future<SearchResult> Engine::start(const BoardState &position,
+                                        std::span<const uint64_t> gameHistory,
+                                        const SearchLimits &limits) {
+  stopAndWait();
+
+  std::promise<SearchResult> promise;
+  std::future<SearchResult> result = promise.get_future();
+
+  searching_.store(true, std::memory_order_relaxed);
+  searchThread_ = std::jthread(
+      [this, position, limits, promise = std::move(promise),
+       history = std::vector<uint64_t>(gameHistory.begin(),
+                                       gameHistory.end())](
+          std::stop_token stopToken) mutable {
+        chess::trace::setThreadName("engine");
+        try {
+          promise.set_value(search(position, history, limits, stopToken));
+        } catch (...) {
+          promise.set_exception(std::current_exception());
+        }
+        searching_.store(false, std::memory_order_relaxed);
+      });
+  return result;
+}
+
+SearchResult Engine::search(const BoardState &position,
+                            std::span<const uint64_t> gameHistory,
+                            const SearchLimits &limits,
+                            std::stop_token stopToken) {
+  return searchPool_.search(position, gameHistory, limits, stopToken);
+}
+
+void Engine::stop() { searchThread_.request_stop(); }
+
+void Engine::stopAndWait() {
+  if (!searchThread_.joinable())
+    return;
+  searchThread_.request_stop();
+  searchThread_.join();
+}
+
+bool Engine::isSearching() const {
+  return searching_.load(std::memory_order_relaxed);
+}
+
+uint64_t Engine::getNodes() const { return searchPool_.getNodes(); }
+
+size_t Engine::getMemoryUsage() const { return searchPool_.getMemoryUsage(); }
+
+void Engine::setProgressCallback(
+    std::function<void(const IterationInfo &)> callback) {
+  stopAndWait();
+  searchPool_.setIterationCallback(std::move(callback));
+}
+
+void Engine::setHelperThreadCount(const size_t count) {
+  stopAndWait();
+  searchPool_.setHelperThreadCount(count);
+  applyMemoryBudget();
+}
+
+void Engine::setHashSize(const size_t megabytes) {
+  stopAndWait();
+  if (memoryBudget_ != 0 &&
+      (megabytes << 20) + getFixedMemoryUsage() > memoryBudget_)
+    throw std::logic_error("Hash size exceeds the memory budget");
+  searchPool_.setHashSize(megabytes);
+}
+
+void Engine::setEvalCacheSize(const size_t megabytes) {
+  stopAndWait();
+  // Checked against what stays besides the cache it replaces, before any of
+  // it is allocated.
+  if (memoryBudget_ != 0 &&
+      (megabytes << 20) + searchPool_.getSearchMemoryUsage() > memoryBudget_)
+    throw std::logic_error("Evaluation cache size exceeds the memory budget");
+  searchPool_.setEvalCacheSize(megabytes);
+  applyMemoryBudget();
+}
+
+void Engine::setSelectivityParams(
+    const chess::search::SelectivityParams &params) {
+  stopAndWait();
+  searchPool_.setSelectivityParams(params);
+}
+
+void Engine::setNetwork(std::shared_ptr<const chess::nnue::Network> network) {
+  stopAndWait();
+  searchPool_.setNetwork(std::move(network));
+}
+
+void Engine::clearHash() {
+  stopAndWait();
+  searchPool_.clearHash();
+}
+
+} // namespace chess::engine
@@ -0,0 +1,99 @@
+module;
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <future>
+#include <span>
+#include <stop_token>
+#include <thread>
+
+export module chess.engine;
+
+import chess.board_state;
+import chess.nnue;
+import chess.search;
+import chess.transposition_table;
+
+export namespace chess::engine {
+
+export struct EngineOptions {
+  size_t helperThreads = 0;
+  // Upper bound in bytes on what the instance allocates: per-thread search
+  // state and the evaluation cache plus its own transposition table, which
+  // gets whatever is left.
+  // Zero keeps the default table size.
+  size_t memoryBudget = 0;
+  // Lets several instances share what they learn. Not counted against the
+  // budget of any of them.
+  std::shared_ptr<chess::search::TranspositionTable> sharedTable;
+};
+
+// Non-blocking front for the search: each search runs on the engine's own
+// thread and delivers its result through a future. Nothing here touches the
+// console, so it can be embedded anywhere.
+//
+// An engine owns all of its search state, so any number of them can search
+// at once, each used from one thread at a time.
+export class Engine {
+private:
+  chess::search::SearchPool searchPool_;
+  size_t memoryBudget_;
+  std::atomic<bool> searching_{false};
+  // Declared last so it is joined before the pool it searches with goes away.
+  std::jthread searchThread_;
+
+  void stopAndWait();
+  void applyMemoryBudget();
+  // Everything under the budget but the transposition table.
+  [[nodiscard]] size_t getFixedMemoryUsage() const;
+
+public:
+  explicit Engine(const EngineOptions &options = {});
+  Engine(const Engine &) = delete;
+  Engine &operator=(const Engine &) = delete;
+
+  // Starts searching `position` and returns at once. A search that is still
+  // running is stopped first. The result is available from the future once
+  // `limits` are reached or stop() is called; it then holds the deepest
+  // completed iteration.
+  std::future<chess::search::SearchResult>
+  start(const chess::board::BoardState &position,
+        std::span<const uint64_t> gameHistory,
+        const chess::search::SearchLimits &limits);
+
+  // Searches on the calling thread instead, for callers that bring their
+  // own thread pool.
+  chess::search::SearchResult
+  search(const chess::board::BoardState &position,
+         std::span<const uint64_t> gameHistory,
+         const chess::search::SearchLimits &limits,
+         std::stop_token stopToken = {});
+
+  // Asks the running search to finish; returns without waiting for it.
+  // The search polls for this at every node.
+  void stop();
+
+  [[nodiscard]] bool isSearching() const;
+  [[nodiscard]] uint64_t getNodes() const;
+  [[nodiscard]] size_t getMemoryUsage() const;
+
+  // Called on the search thread after every completed iteration.
+  void setProgressCallback(
+      std::function<void(const chess::search::IterationInfo &)> callback);
+
+  // These wait for a running search to be stopped before applying. Under a
+  // memory budget the table shrinks to make room for more threads, and
+  // setHashSize and setEvalCacheSize may not exceed the budget.
+  void setHelperThreadCount(size_t count);
+  void setHashSize(size_t megabytes);
+  void setEvalCacheSize(size_t megabytes);
+  void setSelectivityParams(const chess::search::SelectivityParams &params);
+  // A null network switches back to the hand-written evaluation.
+  void setNetwork(std::shared_ptr<const chess::nnue::Network> network);
+  void clearHash();
+};
+
+} // namespace chess::engine
@@ -0,0 +1,59 @@
+module;
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+module chess.eval_cache;
+
+namespace chess::evaluation {
+
+namespace {
+
+constexpr uint64_t SCORE_MASK = 0xFFFF;
+
+} // namespace
+
+EvalCache::EvalCache(const size_t megabytes) { resize(megabytes); }
+
+void EvalCache::resize(const size_t megabytes) {
+  // Round down to a power of two so the index is a mask of the hash.
+  const size_t requested =
+      (std::max(megabytes, MIN_MEGABYTES) << 20) / sizeof(uint64_t);
+  slotCount_ = 1;
+  while (slotCount_ * 2 <= requested)
+    slotCount_ *= 2;
+
+  slots_ = std::make_unique<std::atomic<uint64_t>[]>(slotCount_);
+}
+
+void EvalCache::clear() {
+  for (size_t i = 0; i < slotCount_; ++i)
+    slots_[i].store(0, std::memory_order_relaxed);
+}
+
+std::optional<int> EvalCache::probe(const uint64_t hash) const {
+  const uint64_t data =
+      slots_[hash & (slotCount_ - 1)].load(std::memory_order_relaxed);
+  if (!data || (data & ~SCORE_MASK) != (hash & ~SCORE_MASK))
+    return std::nullopt;
+  return static_cast<int16_t>(data & SCORE_MASK);
+}
+
+void EvalCache::store(const uint64_t hash, const int score) {
+  // Static scores stay far inside 16 bits; anything else is not cached.
+  if (score < INT16_MIN || score > INT16_MAX)
+    return;
+  slots_[hash & (slotCount_ - 1)].store(
+      (hash & ~SCORE_MASK) | static_cast<uint16_t>(score),
+      std::memory_order_relaxed);
+}
+
+size_t EvalCache::getSizeInBytes() const {
+  return slotCount_ * sizeof(uint64_t);
+}
+
+} // namespace chess::evaluation
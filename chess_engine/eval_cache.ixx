@@ -0,0 +1,38 @@
+module;
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+export module chess.eval_cache;
+
+export namespace chess::evaluation {
+
+// Static evaluations keyed by the full position hash, shared by all search
+// threads without locks. Each slot is a single word holding the upper bits
+// of the hash with the score in the low 16, so it can never be torn; the
+// lower bits of the hash are implied by the slot index.
+export class EvalCache {
+private:
+  std::unique_ptr<std::atomic<uint64_t>[]> slots_;
+  size_t slotCount_ = 0;
+
+public:
+  static constexpr size_t MIN_MEGABYTES = 1;
+
+  explicit EvalCache(size_t megabytes = 4);
+
+  // At least MIN_MEGABYTES, so the index covers every bit the key leaves out.
+  void resize(size_t megabytes);
+  void clear();
+
+  // Scores are from the side to move's point of view, like the evaluation.
+  [[nodiscard]] std::optional<int> probe(uint64_t hash) const;
+  void store(uint64_t hash, int score);
+
+  [[nodiscard]] size_t getSizeInBytes() const;
+};
+
+} // namespace chess::evaluation
@@ -0,0 +1,147 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+
+module chess.evaluation;
+
+import chess.core;
+import chess.score;
+import chess.eval_parameters;
+import chess.board_state;
+import chess.attack_map;
+import chess.generator_helpers;
+import chess.pawn_structure;
+
+namespace chess::evaluation {
+
+using chess::board::Bitboard;
+using chess::board::BoardState;
+using chess::board::Color;
+using chess::board::makeScore;
+using chess::board::Name;
+using chess::board::Score;
+using chess::move_generator::AttackMap;
+
+namespace {
+
+// Per square a piece can move to, counted from a typical number of squares
+// so that an average piece scores about zero. Indexed by name.
+constexpr std::array<Score, static_cast<size_t>(Name::COUNT)> MOBILITY = [] {
+  std::array<Score, static_cast<size_t>(Name::COUNT)> scores{};
+  for (size_t name = 0; name < scores.size(); ++name)
+    scores[name] = makeScore(parameters::MOBILITY[name]);
+  return scores;
+}();
+constexpr std::array<int, static_cast<size_t>(Name::COUNT)>
+    MOBILITY_BASELINE = {0, 4, 6, 6, 12, 0};
+
+// Weight of each attacked square next to the enemy king, by attacker.
+constexpr std::array<int, static_cast<size_t>(Name::COUNT)> KING_ATTACK_WEIGHT =
+    {0, 2, 2, 3, 5, 0};
+constexpr int MAX_KING_DANGER = 400;
+
+constexpr Score HANGING_PIECE = makeScore(parameters::HANGING_PIECE);
+
+// Piece terms from one walk over the attack map, as white's advantage. With
+// a `trace`, also counts how often each weight applied.
+Score evaluatePieces(const BoardState &boardState, const AttackMap &attacks,
+                     EvalTrace *trace = nullptr) {
+  std::array<Bitboard, 2> mobilityArea, kingZone;
+  for (const Color color : {Color::WHITE, Color::BLACK}) {
+    const size_t side = static_cast<size_t>(color);
+    const Color opponent = chess::board::getOppositeColor(color);
+    // Squares held by an enemy pawn are not worth counting.
+    mobilityArea[side] = ~boardState.getPieces(color) &
+                         ~attacks.getAttacks(opponent, Name::PAWN);
+    const Bitboard king = boardState.getPieces(color, Name::KING);
+    kingZone[side] =
+        king ? king | chess::move_generator::getKingAttacks(
+                          static_cast<uint8_t>(std::countr_zero(king)))
+             : 0ULL;
+  }
+
+  Score score = 0;
+  std::array<int, 2> kingAttackers{}, kingAttackUnits{};
+  for (size_t i = 0; i < attacks.pieceCount; ++i) {
+    const AttackMap::PieceAttacks &piece = attacks.pieces[i];
+    const size_t side = static_cast<size_t>(piece.color),
+                 enemy = side ^ 1, name = static_cast<size_t>(piece.name);
+
+    const int moves = std::popcount(piece.attacks & mobilityArea[side]);
+    const int sign = piece.color == Color::WHITE ? 1 : -1;
+    score += sign * MOBILITY[name] * (moves - MOBILITY_BASELINE[name]);
+    if (trace)
+      trace->mobility[name] += sign * (moves - MOBILITY_BASELINE[name]);
+
+    if (const Bitboard zoneAttacks = piece.attacks & kingZone[enemy]) {
+      ++kingAttackers[enemy];
+      kingAttackUnits[enemy] +=
+          KING_ATTACK_WEIGHT[name] * std::popcount(zoneAttacks);
+    }
+  }
+
+  for (const Color color : {Color::WHITE, Color::BLACK}) {
+    const size_t side = static_cast<size_t>(color);
+    const int sign = color == Color::WHITE ? 1 : -1;
+    const int hanging = std::popcount(
+        chess::move_generator::getHangingPieces(color, boardState, attacks));
+    // A lone attacker rarely gets anywhere; the danger grows quadratically
+    // with the weight of a coordinated attack.
+    Score kingDanger = 0;
+    if (kingAttackers[side] >= 2) {
+      const int units = kingAttackUnits[side];
+      kingDanger = makeScore(-std::min(units * units / 4, MAX_KING_DANGER), 0);
+    }
+    score += sign * (HANGING_PIECE * hanging + kingDanger);
+    if (trace) {
+      trace->hangingPieces += sign * hanging;
+      trace->kingDanger += sign * kingDanger;
+    }
+  }
+  return score;
+}
+
+int evaluateWith(const BoardState &boardState, const AttackMap &attacks,
+                 const PawnEntry &pawns) {
+  const Score total = boardState.getPieceSquareScore() + pawns.score +
+                      evaluatePieces(boardState, attacks);
+  const int score = chess::board::taper(total, boardState.getPhase());
+  return boardState.getTurnColor() == Color::WHITE ? score : -score;
+}
+
+} // namespace
+
+auto evaluate(const BoardState &boardState, const AttackMap &attacks,
+              PawnTable &pawnTable) -> int {
+  return evaluateWith(boardState, attacks, pawnTable.probe(boardState));
+}
+
+auto evaluate(const BoardState &boardState, PawnTable &pawnTable) -> int {
+  return evaluate(boardState, chess::move_generator::buildAttackMap(boardState),
+                  pawnTable);
+}
+
+auto evaluate(const BoardState &boardState) -> int {
+  return evaluateWith(boardState,
+                      chess::move_generator::buildAttackMap(boardState),
+                      evaluatePawns(boardState));
+}
+
+auto traceEvaluation(const BoardState &boardState) -> EvalTrace {
+  EvalTrace trace;
+  evaluatePieces(boardState, chess::move_generator::buildAttackMap(boardState),
+                 &trace);
+  return trace;
+}
+
+auto evaluateStatic(const BoardState &boardState) -> int {
+  const int score = chess::board::taper(
+      boardState.getPieceSquareScore() + evaluatePawns(boardState).score,
+      boardState.getPhase());
+  return boardState.getTurnColor() == Color::WHITE ? score : -score;
+}
+
+} // namespace chess::evaluation
@@ -0,0 +1,47 @@
+module;
+
+#include <array>
+#include <cstddef>
+
+export module chess.evaluation;
+
+import chess.core;
+import chess.score;
+import chess.board_state;
+import chess.attack_map;
+import chess.pawn_structure;
+
+export namespace chess::evaluation {
+
+// Static evaluation in centipawns, from the side to move's point of view:
+// material, piece placement, pawn structure, mobility, king safety and
+// hanging pieces, each with a middlegame and an endgame value, blended by
+// how much material is left.
+export auto evaluate(const chess::board::BoardState &boardState,
+                     const chess::move_generator::AttackMap &attacks,
+                     PawnTable &pawnTable) -> int;
+// The same, building the attack map itself.
+export auto evaluate(const chess::board::BoardState &boardState,
+                     PawnTable &pawnTable) -> int;
+// The same without a cache, for one-off evaluations.
+export auto evaluate(const chess::board::BoardState &boardState) -> int;
+
+// The terms of the evaluation that are not already visible on the board,
+// for tuning: how many times each weight applied, as white's count minus
+// black's, and the king danger, which is not linear in its weights.
+export struct EvalTrace {
+  // Squares reached beyond the baseline, indexed by name.
+  std::array<int, static_cast<size_t>(chess::board::Name::COUNT)> mobility{};
+  int hangingPieces = 0;
+  chess::board::Score kingDanger = 0;
+};
+
+export auto traceEvaluation(const chess::board::BoardState &boardState)
+    -> EvalTrace;
+
+// Only the terms that follow from the piece placement alone: material,
+// piece-square tables and pawn structure. Cheap enough to run over millions
+// of positions, and the reference for evaluateBatch.
+export auto evaluateStatic(const chess::board::BoardState &boardState) -> int;
+
+} // namespace chess::evaluation
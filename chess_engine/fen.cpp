@@ -0,0 +1,127 @@
+module;
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string_view>
+#include <system_error>
+
+module chess.fen;
+
+import chess.core;
+import chess.board_state;
+
+namespace chess::board {
+
+namespace {
+
+std::optional<Name> getPieceName(const char pieceChar) {
+  switch (std::tolower(static_cast<unsigned char>(pieceChar))) {
+  case 'p':
+    return Name::PAWN;
+  case 'n':
+    return Name::KNIGHT;
+  case 'b':
+    return Name::BISHOP;
+  case 'r':
+    return Name::ROOK;
+  case 'q':
+    return Name::QUEEN;
+  case 'k':
+    return Name::KING;
+  default:
+    return std::nullopt;
+  }
+}
+
+// Splits off the next space separated field, empty once `fen` runs out.
+std::string_view nextField(std::string_view &fen) {
+  const size_t start = fen.find_first_not_of(' ');
+  if (start == std::string_view::npos) {
+    fen = {};
+    return {};
+  }
+  fen.remove_prefix(start);
+  const size_t end = std::min(fen.find(' '), fen.size());
+  const std::string_view field = fen.substr(0, end);
+  fen.remove_prefix(end);
+  return field;
+}
+
+bool placePieces(BoardState &boardState, const std::string_view placement) {
+  uint8_t x = 0, y = 0; // rank 8 first, like the bit layout
+  for (const char c : placement) {
+    if (c == '/') {
+      if (x != 8 || ++y > 7)
+        return false;
+      x = 0;
+    } else if (c >= '1' && c <= '8') {
+      x += c - '0';
+      if (x > 8)
+        return false;
+    } else if (auto name = getPieceName(c)) {
+      if (x > 7)
+        return false;
+      const Color color = std::isupper(static_cast<unsigned char>(c))
+                              ? Color::WHITE
+                              : Color::BLACK;
+      boardState.addPiece(*name, color, 1ULL << (y * 8 + x));
+      ++x;
+    } else {
+      return false;
+    }
+  }
+  return x == 8 && y == 7;
+}
+
+} // namespace
+
+auto parseFen(std::string_view fen) -> std::optional<BoardState> {
+  BoardState boardState{};
+
+  if (!placePieces(boardState, nextField(fen)))
+    return std::nullopt;
+
+  const std::string_view side = nextField(fen);
+  if (side == "b")
+    boardState.swapTurnColor();
+  else if (side != "w")
+    return std::nullopt;
+
+  // A fresh BoardState has every right; drop the ones not listed.
+  const std::string_view castling = nextField(fen);
+  if (castling.empty())
+    return std::nullopt;
+  auto lacks = [&](const char right) {
+    return castling.find(right) == std::string_view::npos;
+  };
+  boardState.updateCastlingRights(Color::WHITE, lacks('K'), lacks('Q'));
+  boardState.updateCastlingRights(Color::BLACK, lacks('k'), lacks('q'));
+
+  const std::string_view enPassant = nextField(fen);
+  if (enPassant.size() == 2 && enPassant[0] >= 'a' && enPassant[0] <= 'h' &&
+      enPassant[1] >= '1' && enPassant[1] <= '8')
+    boardState.setEnPassantSquare(1ULL << (('8' - enPassant[1]) * 8 +
+                                           (enPassant[0] - 'a')));
+  else if (enPassant != "-")
+    return std::nullopt;
+
+  // The fullmove number is not tracked, so only the halfmove clock is read.
+  const std::string_view halfmoveClock = nextField(fen);
+  if (!halfmoveClock.empty()) {
+    uint16_t clock = 0;
+    const char *last = halfmoveClock.data() + halfmoveClock.size();
+    const auto [end, error] =
+        std::from_chars(halfmoveClock.data(), last, clock);
+    if (error != std::errc{} || end != last)
+      return std::nullopt;
+    boardState.setHalfmoveClock(clock);
+  }
+
+  return boardState;
+}
+
+} // namespace chess::board
@@ -0,0 +1,19 @@
+module;
+
+#include <optional>
+#include <string_view>
+
+export module chess.fen;
+
+import chess.board_state;
+
+export namespace chess::board {
+
+export inline constexpr std::string_view START_FEN =
+    "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1";
+
+// Builds a position from Forsyth-Edwards Notation. The move counters may be
+// left out; anything else malformed gives std::nullopt.
+export auto parseFen(std::string_view fen) -> std::optional<BoardState>;
+
+} // namespace chess::board
@@ -1,5 +1,7 @@
 module;
 
+#include <algorithm>
+#include <array>
 #include <bit>
 #include <cstdint>
 #include <optional>
@@ -12,7 +14,6 @@ import chess.board_state;
 import chess.masks;
 import chess.core;
 import chess.cords;
-import chess.move_generator;
 import chess.shifts;
 
 namespace chess::move_generator {
@@ -40,6 +41,28 @@ constexpr chess::board::Bitboard hypQuint(const HypQuintParams &params) {
          params.mask;
 }
 
+// Centipawn values used to resolve exchanges, indexed by Name. The king is
+// worth more than everything else combined so it is never traded.
+constexpr std::array<int, static_cast<size_t>(chess::board::Name::COUNT)>
+    SEE_PIECE_VALUES = {100, 300, 300, 500, 900, 20000};
+
+auto getPieceName(const chess::board::BoardState &boardState,
+                  const chess::board::Bitboard square)
+    -> std::optional<chess::board::Name> {
+  for (size_t colorIndex = 0; colorIndex < 2; ++colorIndex) {
+    for (size_t nameIndex = 0;
+         nameIndex < static_cast<size_t>(chess::board::Name::COUNT);
+         ++nameIndex) {
+      if (square & boardState.getPieces(static_cast<chess::board::Color>(
+                                            colorIndex),
+                                        static_cast<chess::board::Name>(
+                                            nameIndex)))
+        return static_cast<chess::board::Name>(nameIndex);
+    }
+  }
+  return std::nullopt;
+}
+
 } // namespace
 
 #pragma region pawns
@@ -207,9 +230,9 @@ void SliderGenerator::addDiagonalTargets(bool isQueen) const {
                   .square = smallestPiece,
                   .mask = chess::board::DIAGONAL_MASKS2[7 - pieceIndex % 8 +
                                                         pieceIndex / 8]});
-  }
 
-  addMoves(pieceIndex, possibilities);
+    addMoves(pieceIndex, possibilities);
+  }
 }
 
 void SliderGenerator::addOrthogonalTargets(bool isQueen) const {
@@ -277,13 +300,18 @@ void KingGenerator::addCastleTargets() const {
     pieceIndex = pieceInfo->index;
     smallestPiece = pieceInfo->board;
 
+    // No castling out of check or through it. The knight's square on the
+    // queen side only needs to be empty.
+    if (smallestPiece & threats)
+      continue;
+
     const bool isKingFrontRank = smallestPiece & chess::board::RANK_1,
                isKingBackRank = smallestPiece & chess::board::RANK_8;
 
     if (castles.whiteLong && isKingFrontRank)
       addMoves(pieceIndex,
                empty & ~threats & chess::board::shiftWest(empty & ~threats) &
-                   chess::board::shiftEast(empty & ~threats) &
+                   chess::board::shiftEast(empty) &
                    shift(smallestPiece, chess::board::Shift::WEST_DOUBLE),
                chess::board::Move::Type::WHITE_CASTLE_QUEENSIDE);
 
@@ -295,94 +323,199 @@ void KingGenerator::addCastleTargets() const {
 
     if (castles.blackShort && isKingBackRank)
       addMoves(pieceIndex,
-               empty & ~threats & chess::board::shiftWest(empty & ~threats) &
-                   shift(smallestPiece, chess::board::Shift::WEST_DOUBLE),
+               empty & ~threats & chess::board::shiftEast(empty & ~threats) &
+                   shift(smallestPiece, chess::board::Shift::EAST_DOUBLE),
                chess::board::Move::Type::BLACK_CASTLE_KINGSIDE);
 
     if (castles.blackLong && isKingBackRank)
       addMoves(pieceIndex,
                empty & ~threats & chess::board::shiftWest(empty & ~threats) &
-                   chess::board::shiftEast(empty & ~threats) &
-                   shift(smallestPiece, chess::board::Shift::EAST_DOUBLE),
+                   chess::board::shiftEast(empty) &
+                   shift(smallestPiece, chess::board::Shift::WEST_DOUBLE),
                chess::board::Move::Type::BLACK_CASTLE_QUEENSIDE);
   }
 }
 #pragma endregion
 
-auto getThreatSquares(const chess::board::Color color,
-                      const chess::board::BoardState &boardState)
+#pragma region attacks
+auto getPawnAttacks(const chess::board::Color color,
+                    const chess::board::Bitboard pawns)
     -> chess::board::Bitboard {
-  const bool isWhite = (color == chess::board::Color::WHITE);
-
-  chess::board::Bitboard
-      pawns = boardState.getPieces(color, chess::board::Name::PAWN),
-      knights = boardState.getPieces(color, chess::board::Name::KNIGHT),
-      bishops = boardState.getPieces(color, chess::board::Name::BISHOP),
-      rooks = boardState.getPieces(color, chess::board::Name::ROOK),
-      queens = boardState.getPieces(color, chess::board::Name::QUEEN),
-      kings = boardState.getPieces(color, chess::board::Name::KING),
-      allThreats = isWhite ? (chess::board::shiftNorthWest(pawns) &
-                              chess::board::shiftNorthEast(pawns))
-                           : (chess::board::shiftSouthWest(pawns) &
-                              chess::board::shiftSouthEast(pawns)),
-      empty = boardState.getEmpty(), smallestPiece = 0ULL;
-
-  while (auto pieceInfo = chess::board::getNextPiece(knights))
-    allThreats |= (pieceInfo->index > 18
-                       ? chess::board::KNIGHT_SPAN << (pieceInfo->index - 18)
-                       : chess::board::KNIGHT_SPAN >> (18 - pieceInfo->index)) &
-                  ((pieceInfo->index % 8 < 4) ? ~chess::board::FILE_GH
-                                              : ~chess::board::FILE_AB);
-
-  while (auto pieceInfo = chess::board::getNextPiece(bishops))
-    allThreats |=
-        hypQuint(
-            {.empty = empty,
-             .square = pieceInfo->board,
-             .mask = chess::board::DIAGONAL_MASKS1[pieceInfo->index % 8 +
-                                                   pieceInfo->index / 8]}) |
-        hypQuint(
-            {.empty = empty,
-             .square = pieceInfo->board,
-             .mask = chess::board::DIAGONAL_MASKS2[7 - pieceInfo->index % 8 +
-                                                   pieceInfo->index / 8]});
-
-  while (auto pieceInfo = chess::board::getNextPiece(rooks))
-    allThreats |=
-        hypQuint({.empty = empty,
-                  .square = smallestPiece,
-                  .mask = chess::board::FILE_MASKS[pieceInfo->index % 8]}) |
-        hypQuint({.empty = empty,
-                  .square = smallestPiece,
-                  .mask = chess::board::RANK_MASKS[pieceInfo->index / 8]});
-
-  while (auto pieceInfo = chess::board::getNextPiece(queens))
-    allThreats |=
-        hypQuint(
-            {.empty = empty,
-             .square = pieceInfo->board,
-             .mask = chess::board::DIAGONAL_MASKS1[pieceInfo->index % 8 +
-                                                   pieceInfo->index / 8]}) |
-        hypQuint(
-            {.empty = empty,
-             .square = pieceInfo->board,
-             .mask = chess::board::DIAGONAL_MASKS2[7 - pieceInfo->index % 8 +
-                                                   pieceInfo->index / 8]}) |
-        hypQuint({.empty = empty,
-                  .square = smallestPiece,
-                  .mask = chess::board::FILE_MASKS[pieceInfo->index % 8]}) |
-        hypQuint({.empty = empty,
-                  .square = smallestPiece,
-                  .mask = chess::board::RANK_MASKS[pieceInfo->index / 8]});
+  return color == chess::board::Color::WHITE
+             ? chess::board::shiftNorthWest(pawns) |
+                   chess::board::shiftNorthEast(pawns)
+             : chess::board::shiftSouthWest(pawns) |
+                   chess::board::shiftSouthEast(pawns);
+}
+
+auto getKnightAttacks(const uint8_t index) -> chess::board::Bitboard {
+  return (index > 18 ? chess::board::KNIGHT_SPAN << (index - 18)
+                     : chess::board::KNIGHT_SPAN >> (18 - index)) &
+         (index % 8 < 4 ? ~chess::board::FILE_GH : ~chess::board::FILE_AB);
+}
 
-  while (auto pieceInfo = chess::board::getNextPiece(kings))
-    allThreats |= (pieceInfo->index > 9
-                       ? chess::board::KING_SPAN << (pieceInfo->index - 9)
-                       : chess::board::KING_SPAN >> (9 - pieceInfo->index)) &
-                  ((pieceInfo->index % 8 < 4) ? ~chess::board::FILE_GH
-                                              : ~chess::board::FILE_AB);
+auto getKingAttacks(const uint8_t index) -> chess::board::Bitboard {
+  return (index > 9 ? chess::board::KING_SPAN << (index - 9)
+                    : chess::board::KING_SPAN >> (9 - index)) &
+         (index % 8 < 4 ? ~chess::board::FILE_GH : ~chess::board::FILE_AB);
+}
 
-  return allThreats;
+auto getBishopAttacks(const uint8_t index, const chess::board::Bitboard empty)
+    -> chess::board::Bitboard {
+  const chess::board::Bitboard square = 1ULL << index;
+  return hypQuint({.empty = empty,
+                   .square = square,
+                   .mask = chess::board::DIAGONAL_MASKS1[index % 8 +
+                                                         index / 8]}) |
+         hypQuint({.empty = empty,
+                   .square = square,
+                   .mask = chess::board::DIAGONAL_MASKS2[7 - index % 8 +
+                                                         index / 8]});
 }
 
+auto getRookAttacks(const uint8_t index, const chess::board::Bitboard empty)
+    -> chess::board::Bitboard {
+  const chess::board::Bitboard square = 1ULL << index;
+  return hypQuint({.empty = empty,
+                   .square = square,
+                   .mask = chess::board::FILE_MASKS[index % 8]}) |
+         hypQuint({.empty = empty,
+                   .square = square,
+                   .mask = chess::board::RANK_MASKS[index / 8]});
+}
+
+auto getAttackersTo(const chess::board::BoardState &boardState,
+                    const uint8_t index, const chess::board::Bitboard occupied)
+    -> chess::board::Bitboard {
+  using chess::board::Color;
+  using chess::board::Name;
+
+  const chess::board::Bitboard square = 1ULL << index,
+                               empty = ~occupied,
+                               diagonalSliders =
+                                   boardState.getPieces(Color::WHITE,
+                                                        Name::BISHOP) |
+                                   boardState.getPieces(Color::BLACK,
+                                                        Name::BISHOP) |
+                                   boardState.getPieces(Color::WHITE,
+                                                        Name::QUEEN) |
+                                   boardState.getPieces(Color::BLACK,
+                                                        Name::QUEEN),
+                               orthogonalSliders =
+                                   boardState.getPieces(Color::WHITE,
+                                                        Name::ROOK) |
+                                   boardState.getPieces(Color::BLACK,
+                                                        Name::ROOK) |
+                                   boardState.getPieces(Color::WHITE,
+                                                        Name::QUEEN) |
+                                   boardState.getPieces(Color::BLACK,
+                                                        Name::QUEEN);
+
+  // A white pawn attacks `square` exactly when a black pawn on `square` would
+  // attack the white pawn, and vice versa.
+  return ((getPawnAttacks(Color::BLACK, square) &
+           boardState.getPieces(Color::WHITE, Name::PAWN)) |
+          (getPawnAttacks(Color::WHITE, square) &
+           boardState.getPieces(Color::BLACK, Name::PAWN)) |
+          (getKnightAttacks(index) &
+           (boardState.getPieces(Color::WHITE, Name::KNIGHT) |
+            boardState.getPieces(Color::BLACK, Name::KNIGHT))) |
+          (getKingAttacks(index) &
+           (boardState.getPieces(Color::WHITE, Name::KING) |
+            boardState.getPieces(Color::BLACK, Name::KING))) |
+          (getBishopAttacks(index, empty) & diagonalSliders) |
+          (getRookAttacks(index, empty) & orthogonalSliders)) &
+         occupied;
+}
+#pragma endregion
+
+#pragma region static_exchange
+auto isCapture(const chess::board::BoardState &boardState,
+               const chess::board::Move &move) -> bool {
+  return move.getType() == chess::board::Move::Type::EN_PASSANT ||
+         (move.getEndBoard() &
+          boardState.getPieces(
+              chess::board::getOppositeColor(boardState.getTurnColor())));
+}
+
+auto staticExchangeEvaluation(const chess::board::BoardState &boardState,
+                              const chess::board::Move &move) -> int {
+  using chess::board::Bitboard;
+  using chess::board::Color;
+  using chess::board::Name;
+
+  const uint8_t target = move.getEndSquare().getIndex();
+  const Bitboard startBoard = move.getStartBoard(),
+                 endBoard = move.getEndBoard();
+
+  Bitboard occupied = ~boardState.getEmpty();
+  std::array<int, 32> gain{};
+  uint8_t depth = 0;
+
+  // The piece standing on the target square is the first one lost; en
+  // passant captures a pawn that is not on the target square at all.
+  if (move.getType() == chess::board::Move::Type::EN_PASSANT) {
+    gain[0] = SEE_PIECE_VALUES[static_cast<size_t>(Name::PAWN)];
+    occupied ^= boardState.getTurnColor() == Color::WHITE
+                    ? chess::board::shiftSouth(endBoard)
+                    : chess::board::shiftNorth(endBoard);
+  } else if (auto captured = getPieceName(boardState, endBoard)) {
+    gain[0] = SEE_PIECE_VALUES[static_cast<size_t>(*captured)];
+  }
+
+  Name attackerName = getPieceName(boardState, startBoard).value_or(Name::PAWN);
+  if (auto promotionName = move.tryGetPromotionName()) {
+    gain[0] += SEE_PIECE_VALUES[static_cast<size_t>(*promotionName)] -
+               SEE_PIECE_VALUES[static_cast<size_t>(Name::PAWN)];
+    attackerName = *promotionName;
+  }
+
+  occupied ^= startBoard;
+  Bitboard attackers = getAttackersTo(boardState, target, occupied);
+  Color side = chess::board::getOppositeColor(boardState.getTurnColor());
+
+  while (depth + 1 < static_cast<uint8_t>(gain.size())) {
+    ++depth;
+    // Speculative score if `side` recaptures the piece now on the square;
+    // discarded by the unwind below when no recapture is possible.
+    gain[depth] =
+        SEE_PIECE_VALUES[static_cast<size_t>(attackerName)] - gain[depth - 1];
+
+    const Bitboard sideAttackers = attackers & boardState.getPieces(side);
+    Bitboard nextAttacker = 0ULL;
+    for (size_t nameIndex = 0;
+         nameIndex < static_cast<size_t>(Name::COUNT) && !nextAttacker;
+         ++nameIndex) {
+      const Bitboard candidates =
+          sideAttackers & boardState.getPieces(side, static_cast<Name>(nameIndex));
+      if (candidates) {
+        nextAttacker = candidates & (~candidates + 1); // isolate lowest bit
+        attackerName = static_cast<Name>(nameIndex);
+      }
+    }
+
+    if (!nextAttacker)
+      break;
+
+    // A king may only recapture last; stepping into a defended square
+    // would be illegal.
+    if (attackerName == Name::KING &&
+        (attackers & boardState.getPieces(getOppositeColor(side))))
+      break;
+
+    // Removing the attacker may uncover a slider lined up behind it.
+    occupied ^= nextAttacker;
+    attackers = getAttackersTo(boardState, target, occupied);
+    side = chess::board::getOppositeColor(side);
+  }
+
+  // Unwind the sequence: each side picks the better of capturing or
+  // declining at every step.
+  while (--depth)
+    gain[depth - 1] = -std::max(-gain[depth - 1], gain[depth]);
+
+  return gain[0];
+}
+#pragma endregion
+
 } // namespace chess::move_generator
\ No newline at end of file
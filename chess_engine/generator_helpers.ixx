@@ -3,7 +3,6 @@ module;
 #include <bit>
 #include <cstdint>
 #include <optional>
-#include <vector>
 
 export module chess.generator_helpers;
 
@@ -15,13 +14,13 @@ export namespace chess::move_generator {
 
 export struct PawnGenerator {
   struct Params {
-    std::vector<chess::board::Move> &moveList;
+    chess::board::MoveList &moveList;
     const chess::board::BoardState &boardState;
     chess::board::Bitboard pawns = 0ULL, promotionRank = 0ULL,
                            pawnStartRank = 0ULL, enPassantTargetSquare = 0ULL;
   };
 
-  std::vector<chess::board::Move> &moveList;
+  chess::board::MoveList &moveList;
   chess::board::Color color;
   chess::board::Bitboard pawns, empty, occupied, friendlyPieces, promotionRank,
       pawnStartRank, enPassantTargetSquare;
@@ -40,12 +39,12 @@ export struct PawnGenerator {
 
 export struct KnightGenerator {
   struct Params {
-    std::vector<chess::board::Move> &moveList;
+    chess::board::MoveList &moveList;
     chess::board::BoardState boardState;
     chess::board::Bitboard knights = 0ULL;
   };
 
-  std::vector<chess::board::Move> &moveList;
+  chess::board::MoveList &moveList;
   chess::board::Color color;
   chess::board::Bitboard knights, empty, occupied, friendlyPieces;
 
@@ -55,12 +54,12 @@ export struct KnightGenerator {
 
 export struct SliderGenerator {
   struct Params {
-    std::vector<chess::board::Move> &moveList;
+    chess::board::MoveList &moveList;
     chess::board::BoardState boardState;
     chess::board::Bitboard bishops = 0ULL, rooks = 0ULL, queens = 0ULL;
   };
 
-  std::vector<chess::board::Move> &moveList;
+  chess::board::MoveList &moveList;
   chess::board::Color color;
   chess::board::Bitboard bishops, rooks, queens, empty, occupied,
       friendlyPieces;
@@ -73,13 +72,13 @@ export struct SliderGenerator {
 
 export struct KingGenerator {
   struct Params {
-    std::vector<chess::board::Move> &moveList;
+    chess::board::MoveList &moveList;
     chess::board::BoardState boardState;
     chess::board::Bitboard kings = 0ULL, threats = 0ULL;
     chess::board::BoardState::Castles castles;
   };
 
-  std::vector<chess::board::Move> &moveList;
+  chess::board::MoveList &moveList;
   chess::board::Color color;
   chess::board::Bitboard kings, empty, occupied, friendlyPieces, threats;
   chess::board::BoardState::Castles castles;
@@ -92,4 +91,38 @@ export struct KingGenerator {
   void addCastleTargets() const;
 };
 
+// --- Attack Sets ---
+// Attacks of a single piece standing on `index`. Sliders stop at the first
+// occupied square in each direction, which is included in the set.
+
+export auto getPawnAttacks(const chess::board::Color color,
+                           const chess::board::Bitboard pawns)
+    -> chess::board::Bitboard;
+export auto getKnightAttacks(const uint8_t index) -> chess::board::Bitboard;
+export auto getKingAttacks(const uint8_t index) -> chess::board::Bitboard;
+export auto getBishopAttacks(const uint8_t index,
+                             const chess::board::Bitboard empty)
+    -> chess::board::Bitboard;
+export auto getRookAttacks(const uint8_t index,
+                           const chess::board::Bitboard empty)
+    -> chess::board::Bitboard;
+
+// Every piece of either color attacking `index`, given an occupancy that may
+// differ from the board's own (used to uncover x-ray attackers).
+export auto getAttackersTo(const chess::board::BoardState &boardState,
+                           const uint8_t index,
+                           const chess::board::Bitboard occupied)
+    -> chess::board::Bitboard;
+
+// --- Static Exchange Evaluation ---
+
+// Material balance (in centipawns, from the mover's point of view) of the
+// capture sequence started by `move` on its end square, assuming both sides
+// always recapture with their least valuable attacker and may stop at will.
+export auto staticExchangeEvaluation(const chess::board::BoardState &boardState,
+                                     const chess::board::Move &move) -> int;
+
+export auto isCapture(const chess::board::BoardState &boardState,
+                      const chess::board::Move &move) -> bool;
+
 } // namespace chess::move_generator
\ No newline at end of file
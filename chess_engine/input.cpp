@@ -1,99 +1,105 @@
-#include "input.hpp"
+module;
 
-namespace chess_input {
+#include <charconv>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
 
-namespace {
+module chess.input;
 
-chess_board::Move
-resolveAmbiguousMove(const std::vector<chess_board::Move> &chosenMoves) {
-  std::uint8_t counter = 0;
+import chess.core;
+import chess.board_state;
+import chess.move;
+import chess.notation;
+import chess.search;
 
-  for (const chess_board::Move &move : chosenMoves) {
-    std::cout << "#" << counter++ << " - Move: " << move.getMoveString();
-  }
-  std::cout << "\n";
+namespace chess::input {
 
-  int choice;
-  std::cout << "Enter the number of your choice: ";
-  std::cin >> choice;
-  return chosenMoves[choice];
-}
+namespace {
 
-std::vector<chess_board::Move>
-getMatchingMoves(const chess_board::Move move,
-                 const std::vector<chess_board::Move> &possibleMoves) {
-  std::vector<chess_board::Move> matchingMoves;
-  for (const auto &possibleMove : possibleMoves) {
-    if (move.getStartSquare() == possibleMove.getStartSquare() &&
-        move.getEndSquare() == possibleMove.getEndSquare()) {
-      matchingMoves.push_back(possibleMove);
-    }
-  }
-  return matchingMoves;
+// Reads the next word of input. Throws std::logic_error once input ends.
+std::string readWord() {
+  std::string word;
+  if (!(std::cin >> word))
+    throw std::logic_error("Input ended");
+  return word;
 }
 
-chess_board::Move getMoveFromString(const std::string &moveString) {
-  std::uint8_t x1 = static_cast<std::uint8_t>(moveString[0] - '0'),
-               y1 = static_cast<std::uint8_t>(moveString[1] - '0'),
-               x2 = static_cast<std::uint8_t>(moveString[2] - '0'),
-               y2 = static_cast<std::uint8_t>(moveString[3] - '0');
+std::optional<int> parseChoice(const std::string_view word, const int min,
+                               const int max) {
+  int value;
+  const auto [end, error] =
+      std::from_chars(word.data(), word.data() + word.size(), value);
+  if (error != std::errc{} || end != word.data() + word.size() ||
+      value < min || value > max)
+    return std::nullopt;
+  return value;
+}
 
-  return chess_board::Move(chess_board::Cords(x1, y1),
-                           chess_board::Cords(x2, y2));
+// Asks until the answer is a whole number from `min` to `max`.
+int readChoice(const std::string_view prompt, const int min, const int max) {
+  while (true) {
+    std::cout << prompt;
+    if (const auto value = parseChoice(readWord(), min, max))
+      return *value;
+    std::cout << "Please enter a number from " << min << " to " << max
+              << ".\n";
+  }
 }
 
 } // namespace
 
-chess_board::Move
-getPlayerMove(const std::vector<chess_board::Move> &possibleMoves) {
+auto getPlayerMove(const chess::board::BoardState &boardState)
+    -> chess::board::Move {
   while (true) {
-    std::string moveString;
-    std::cout << "Enter your move (xyxy): ";
-    std::cin >> moveString;
+    std::cout << "Enter your move (e2e4 or Nf3): ";
+    const std::string text = readWord();
     std::cout << "\n";
 
-    chess_board::Move move = getMoveFromString(moveString);
-
-    std::vector<chess_board::Move> matchingMoves =
-        getMatchingMoves(move, possibleMoves);
-
-    if (matchingMoves.size() == 1) // remove if not testing
-      move = matchingMoves[0]; // in case the only move that matches is special
-
-    if (matchingMoves.size() > 1)
-      move = resolveAmbiguousMove(matchingMoves);
-
-    // if (matchingMoves.size() != 0)
-    return move;
+    if (auto move = chess::notation::parseUci(boardState, text))
+      return *move;
+    if (auto move = chess::notation::parseSan(boardState, text))
+      return *move;
+    std::cout << text << " is not a legal move here.\n";
   }
 }
 
 GameParams gatherInputs() {
+  // GUIs open with "uci", so it is accepted in place of the first answer.
   OpponentType opponentType;
-  chess_board::Color playerColor;
-  int depth;
-
-  std::cout << "Play against (0 for HUMAN, 1 for ENGINE): ";
-  int opponentTypeInput;
-  std::cin >> opponentTypeInput;
-  opponentType = static_cast<OpponentType>(opponentTypeInput);
+  while (true) {
+    std::cout
+        << "Play against (0 for HUMAN, 1 for ENGINE, uci for UCI mode): ";
+    const std::string answer = readWord();
+    if (answer == "uci")
+      return {OpponentType::UCI, chess::board::Color::WHITE, 0, 0, false};
+    if (const auto choice = parseChoice(answer, 0, 1)) {
+      opponentType = static_cast<OpponentType>(*choice);
+      break;
+    }
+    std::cout << "Please enter 0, 1 or uci.\n";
+  }
 
   if (opponentType == OpponentType::HUMAN) {
     std::cout << "\n";
-    return {opponentType, chess_board::Color::WHITE, 0};
+    return {opponentType, chess::board::Color::WHITE, 0, 0, false};
   }
 
-  std::cout << "Play as (0 for WHITE, 1 for BLACK): ";
-  int playerColorInput;
-  std::cin >> playerColorInput;
-  playerColor = static_cast<chess_board::Color>(playerColorInput);
-
-  std::cout << "Enter search depth for engine: ";
-  std::cin >> depth;
+  const auto playerColor = static_cast<chess::board::Color>(
+      readChoice("Play as (0 for WHITE, 1 for BLACK): ", 0, 1));
+  const int depth = readChoice("Enter search depth for engine: ", 1,
+                               chess::search::MAX_PLY - 1);
+  const int helperThreads =
+      readChoice("Enter number of helper search threads: ", 0, 63);
+  const bool ponder =
+      readChoice("Ponder on your time (0 for NO, 1 for YES): ", 0, 1) == 1;
 
   std::cout << "\n";
 
-  return {opponentType, playerColor, depth};
+  return {opponentType, playerColor, depth, helperThreads, ponder};
 }
 
-} // namespace chess_input
\ No newline at end of file
+} // namespace chess::input
\ No newline at end of file
@@ -2,22 +2,26 @@ module;
 
 export module chess.input;
 
+import chess.board_state;
 import chess.move;
 import chess.core;
-import <vector>;
 
 export namespace chess::input {
 
-export enum class OpponentType { HUMAN, ENGINE };
+// UCI hands the game over to a GUI speaking the Universal Chess Interface.
+export enum class OpponentType { HUMAN, ENGINE, UCI };
 
 export struct GameParams {
   OpponentType opponentType;
   chess::board::Color playerColor;
   int depth;
+  int helperThreads;
+  bool ponder;
 };
 
 export auto gatherInputs() -> GameParams;
-export auto getPlayerMove(const std::vector<chess::board::Move> &possibleMoves)
+// Reads moves in UCI or SAN form until one is legal in `boardState`.
+export auto getPlayerMove(const chess::board::BoardState &boardState)
     -> chess::board::Move;
 
 } // namespace chess::input
\ No newline at end of file
@@ -6,11 +6,110 @@
  * @date May 4, 2025
  */
 
-#include "board.hpp"
+#include <iostream>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
 
-int main() {
-  chess_board::Board board;
-  board.startGame();
+import chess.bench;
+import chess.board;
+import chess.datagen;
+import chess.microbench;
+import chess.perft;
+import chess.selfcheck;
+import chess.input;
+import chess.match;
+import chess.tuner;
+import chess.uci;
+
+int main(int argc, char *argv[]) {
+  // `chess_engine bench [depth] [threads=N] [counters] [allocs] [noalloc]
+  // [trace] [file.nnue]` runs the benchmark and exits.
+  if (argc > 1 && std::string_view(argv[1]) == "bench") {
+    const std::vector<std::string_view> words(argv + 2, argv + argc);
+    chess::bench::runBench(std::cout, chess::bench::parseBenchArguments(words));
+    return 0;
+  }
+  // `chess_engine microbench` times the board primitives, as JSON.
+  if (argc > 1 && std::string_view(argv[1]) == "microbench") {
+    chess::microbench::runMicrobenchmarks(std::cout);
+    return 0;
+  }
+
+  // `chess_engine perft [counters]` checks the move generator against the
+  // published leaf counts of the standard positions; the exit code is 1 on a
+  // mismatch.
+  if (argc > 1 && std::string_view(argv[1]) == "perft") {
+    const bool hardwareCounters =
+        argc > 2 && std::string_view(argv[2]) == "counters";
+    return chess::perft::runPerftSuite(std::cout, hardwareCounters) ? 0 : 1;
+  }
+
+  // `chess_engine selfcheck [file.nnue]` checks the optimized evaluation
+  // paths against their reference ones on random positions; the exit code
+  // is 1 on a mismatch.
+  if (argc > 1 && std::string_view(argv[1]) == "selfcheck")
+    return chess::selfcheck::runSelfCheck(std::cout, argc > 2 ? argv[2] : "")
+               ? 0
+               : 1;
+
+  // `chess_engine tune <dataset> [epochs=N] [rate=X] [threads=N]
+  // [positions=N] [out=FILE]` tunes the evaluation weights on a labelled
+  // dataset and writes them out in the layout of eval_parameters.ixx, by
+  // default to eval_parameters.tuned.
+  if (argc > 1 && std::string_view(argv[1]) == "tune") {
+    const std::vector<std::string_view> words(argv + 2, argv + argc);
+    try {
+      chess::tuner::runTuner(std::cout,
+                             chess::tuner::parseTuneArguments(words));
+    } catch (const std::logic_error &error) {
+      std::cerr << error.what() << std::endl;
+      return 1;
+    }
+    return 0;
+  }
+
+  // `chess_engine match [key=value ...]` plays the engine against itself
+  // under two configurations; see chess::match::parseMatchArguments.
+  if (argc > 1 && std::string_view(argv[1]) == "match") {
+    const std::vector<std::string_view> words(argv + 2, argv + argc);
+    chess::match::runMatch(std::cout, chess::match::parseMatchArguments(words));
+    return 0;
+  }
+
+  // `chess_engine datagen [key=value ...]` writes self-play training data;
+  // see chess::datagen::parseDatagenArguments.
+  if (argc > 1 && std::string_view(argv[1]) == "datagen") {
+    const std::vector<std::string_view> words(argv + 2, argv + argc);
+    chess::datagen::runDatagen(std::cout,
+                               chess::datagen::parseDatagenArguments(words));
+    return 0;
+  }
+
+  // `chess_engine uci` speaks UCI from the start, without the console
+  // prompts; this is the command to give a GUI.
+  if (argc > 1 && std::string_view(argv[1]) == "uci") {
+    chess::uci::UciFrontEnd frontEnd;
+    frontEnd.run(false);
+    return 0;
+  }
+
+  try {
+    const chess::input::GameParams inputs = chess::input::gatherInputs();
+
+    if (inputs.opponentType == chess::input::OpponentType::UCI) {
+      chess::uci::UciFrontEnd frontEnd;
+      frontEnd.run(true);
+      return 0;
+    }
+
+    chess::board::Board board;
+    board.startGame(inputs);
+  } catch (const std::logic_error &error) {
+    // The console was closed partway through.
+    std::cerr << error.what() << std::endl;
+    return 1;
+  }
 
   return 0;
 }
\ No newline at end of file
@@ -0,0 +1,493 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <ostream>
+#include <random>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+module chess.match;
+
+import chess.core;
+import chess.board_state;
+import chess.move;
+import chess.fen;
+import chess.notation;
+import chess.move_executor;
+import chess.move_generator;
+import chess.repetition;
+import chess.nnue;
+import chess.search;
+import chess.selfplay;
+import chess.engine;
+
+namespace chess::match {
+
+using chess::board::BoardState;
+using chess::board::Color;
+using chess::board::Move;
+using chess::board::MoveList;
+using chess::board::Name;
+
+namespace {
+
+#pragma region openings
+struct Opening {
+  BoardState start;
+  // The FEN tag of the game; empty when it starts from the initial position.
+  std::string fen;
+  // Played before the engines take over.
+  std::vector<Move> moves;
+};
+
+// Up to the en passant square, with fresh move counters, since EPD has none
+// and the games are numbered from 1 anyway.
+std::optional<Opening> parseOpening(const std::string_view line) {
+  size_t end = 0;
+  for (int field = 0; field < 4 && end != std::string_view::npos; ++field)
+    end = line.find(' ', line.find_first_not_of(' ', end));
+  std::string fen(line.substr(0, end));
+  fen += " 0 1";
+  std::optional<BoardState> start = chess::board::parseFen(fen);
+  if (!start)
+    return std::nullopt;
+  return Opening{*start, std::move(fen), {}};
+}
+
+std::vector<Opening> loadOpenings(const MatchOptions &options,
+                                  const size_t pairs) {
+  std::vector<Opening> openings;
+  if (options.openingsFile.empty()) {
+    const BoardState initial =
+        *chess::board::parseFen(chess::board::START_FEN);
+    std::mt19937_64 random(options.seed);
+    for (size_t pair = 0; pair < pairs; ++pair)
+      openings.push_back(
+          {initial, "",
+           chess::selfplay::makeRandomOpening(options.randomOpeningPlies,
+                                              random)
+               .moves});
+    return openings;
+  }
+
+  std::ifstream file(options.openingsFile);
+  if (!file)
+    throw std::logic_error("Cannot open openings " + options.openingsFile);
+  std::string line;
+  while (std::getline(file, line)) {
+    if (std::optional<Opening> opening = parseOpening(line))
+      openings.push_back(std::move(*opening));
+  }
+  if (openings.empty())
+    throw std::logic_error("No positions in " + options.openingsFile);
+  // Shuffled, so a short match does not just play the first few lines.
+  std::shuffle(openings.begin(), openings.end(),
+               std::mt19937_64(options.seed));
+  return openings;
+}
+#pragma endregion
+
+#pragma region games
+enum class Outcome { WHITE_WINS, BLACK_WINS, DRAW };
+
+struct Game {
+  const Opening *opening;
+  std::array<const EngineConfig *, 2> players; // by color
+  std::vector<Move> moves; // after the opening's
+  Outcome outcome = Outcome::DRAW;
+  std::string_view reason;
+};
+
+void playGame(Game &game, std::array<chess::engine::Engine *, 2> engines,
+              const MatchOptions &options,
+              const chess::search::SearchLimits &limits) {
+  BoardState position = game.opening->start;
+  std::vector<uint64_t> history{position.getHash()};
+  for (const Move &move : game.opening->moves) {
+    chess::move_executor::doMove(position, move);
+    history.push_back(position.getHash());
+  }
+  for (chess::engine::Engine *engine : engines)
+    engine->clearHash();
+
+  chess::selfplay::Adjudicator adjudicator(options.adjudication);
+  MoveList legalMoves;
+  for (int ply = static_cast<int>(game.opening->moves.size());; ++ply) {
+    const Color turnColor = position.getTurnColor();
+    const auto winFor = [](const Color color) {
+      return color == Color::WHITE ? Outcome::WHITE_WINS
+                                   : Outcome::BLACK_WINS;
+    };
+
+    chess::move_generator::getLegalMoves(position, legalMoves);
+    if (legalMoves.empty()) {
+      if (chess::move_generator::isInCheck(turnColor, position)) {
+        game.outcome = winFor(getOppositeColor(turnColor));
+        game.reason = "checkmate";
+      } else {
+        game.reason = "stalemate";
+      }
+      return;
+    }
+    if (chess::search::isFiftyMoveDraw(position)) {
+      game.reason = "fifty move rule";
+      return;
+    }
+    if (chess::search::isRepetition(history, position.getHalfmoveClock(), 0)) {
+      game.reason = "threefold repetition";
+      return;
+    }
+    if (chess::search::hasInsufficientMaterial(position)) {
+      game.reason = "insufficient material";
+      return;
+    }
+    if (ply >= options.maxPly) {
+      game.reason = "move limit";
+      return;
+    }
+
+    const chess::search::SearchResult result =
+        engines[static_cast<size_t>(turnColor)]->search(position, history,
+                                                        limits);
+    if (std::find(legalMoves.begin(), legalMoves.end(), result.bestMove) ==
+        legalMoves.end()) {
+      game.outcome = winFor(getOppositeColor(turnColor));
+      game.reason = "illegal move";
+      return;
+    }
+
+    adjudicator.addScore(ply, turnColor == Color::WHITE ? result.score
+                                                        : -result.score);
+
+    game.moves.push_back(result.bestMove);
+    chess::move_executor::doMove(position, result.bestMove);
+    history.push_back(position.getHash());
+
+    using chess::selfplay::Verdict;
+    const Verdict verdict = adjudicator.getVerdict();
+    if (verdict == Verdict::DRAW) {
+      game.reason = "adjudicated draw";
+      return;
+    }
+    if (verdict != Verdict::NONE) {
+      game.outcome = verdict == Verdict::WHITE_WINS ? Outcome::WHITE_WINS
+                                                    : Outcome::BLACK_WINS;
+      game.reason = "adjudicated win";
+      return;
+    }
+  }
+}
+
+std::string_view getResultTag(const Outcome outcome) {
+  switch (outcome) {
+  case Outcome::WHITE_WINS:
+    return "1-0";
+  case Outcome::BLACK_WINS:
+    return "0-1";
+  default:
+    return "1/2-1/2";
+  }
+}
+
+void writePgn(std::ostream &out, const Game &game, const size_t round) {
+  out << "[Event \"chess_engine match\"]\n[Site \"?\"]\n"
+      << "[Date \"????.??.??\"]\n[Round \"" << round << "\"]\n"
+      << "[White \"" << game.players[0]->name << "\"]\n"
+      << "[Black \"" << game.players[1]->name << "\"]\n"
+      << "[Result \"" << getResultTag(game.outcome) << "\"]\n";
+  if (!game.opening->fen.empty())
+    out << "[FEN \"" << game.opening->fen << "\"]\n[SetUp \"1\"]\n";
+  out << '\n';
+
+  std::string line;
+  const auto write = [&](const std::string_view text) {
+    if (line.size() + 1 + text.size() > 79) {
+      out << line << '\n';
+      line.clear();
+    }
+    if (!line.empty())
+      line += ' ';
+    line += text;
+  };
+
+  BoardState position = game.opening->start;
+  int moveNumber = 1;
+  bool first = true;
+  std::array<char, chess::notation::MAX_SAN_LENGTH> san;
+  const auto play = [&](const Move &move) {
+    const bool isWhite = position.getTurnColor() == Color::WHITE;
+    if (isWhite || first)
+      write(std::to_string(moveNumber) + (isWhite ? "." : "..."));
+    const auto end = chess::notation::toSan(san.data(),
+                                            san.data() + san.size(), position,
+                                            move)
+                         .ptr;
+    write(std::string_view(san.data(), static_cast<size_t>(end - san.data())));
+    if (!isWhite)
+      ++moveNumber;
+    first = false;
+    chess::move_executor::doMove(position, move);
+  };
+  for (const Move &move : game.opening->moves)
+    play(move);
+  for (const Move &move : game.moves)
+    play(move);
+
+  write("{" + std::string(game.reason) + "}");
+  write(getResultTag(game.outcome));
+  out << line << "\n\n";
+}
+#pragma endregion
+
+#pragma region statistics
+double getExpectedScore(const double elo) {
+  return 1.0 / (1.0 + std::pow(10.0, -elo / 400.0));
+}
+
+double getElo(const double score) {
+  return -400.0 * std::log10(1.0 / score - 1.0);
+}
+
+// Mean score per game and its variance, from the first engine's side.
+std::pair<double, double> getScoreMoments(const double wins,
+                                          const double draws,
+                                          const double losses) {
+  const double games = wins + draws + losses;
+  const double score = (wins + 0.5 * draws) / games;
+  const double variance = (wins * (1.0 - score) * (1.0 - score) +
+                           draws * (0.5 - score) * (0.5 - score) +
+                           losses * score * score) /
+                          games;
+  return {score, variance};
+}
+
+// Logistic Elo with a 95% interval from the normal approximation, and the
+// log-likelihood ratio of elo1 against elo0 under the same approximation.
+void updateStatistics(MatchResult &result, const MatchOptions &options) {
+  const double games =
+      static_cast<double>(result.wins + result.draws + result.losses);
+  const auto [score, variance] = getScoreMoments(
+      static_cast<double>(result.wins), static_cast<double>(result.draws),
+      static_cast<double>(result.losses));
+  // A perfect score says nothing about how large the difference is.
+  const double clamped = std::clamp(score, 1e-3, 1.0 - 1e-3);
+  const double deviation = std::sqrt(variance / games);
+  result.elo = getElo(clamped);
+  result.eloMargin =
+      (getElo(std::clamp(clamped + 1.96 * deviation, 1e-3, 1.0 - 1e-3)) -
+       getElo(std::clamp(clamped - 1.96 * deviation, 1e-3, 1.0 - 1e-3))) /
+      2.0;
+
+  // Half a game of each outcome as a prior, so a one-sided start, which
+  // has no variance yet, still moves the test.
+  const auto [priorScore, priorVariance] = getScoreMoments(
+      result.wins + 0.5, result.draws + 0.5, result.losses + 0.5);
+  const double score0 = getExpectedScore(options.elo0),
+               score1 = getExpectedScore(options.elo1);
+  result.llr = games * (score1 - score0) *
+               (2.0 * priorScore - score0 - score1) / (2.0 * priorVariance);
+  if (result.llr >= std::log((1.0 - options.beta) / options.alpha))
+    result.sprtDecision = 1;
+  else if (result.llr <= std::log(options.beta / (1.0 - options.alpha)))
+    result.sprtDecision = -1;
+}
+
+void writeStatus(std::ostream &out, const MatchResult &result,
+                 const MatchOptions &options, const size_t totalGames) {
+  out << "Games " << result.wins + result.draws + result.losses << " of "
+      << totalGames << ": +" << result.wins << " -" << result.losses << " ="
+      << result.draws << std::fixed << std::setprecision(1) << ", Elo "
+      << result.elo << " +/- " << result.eloMargin << ", LLR "
+      << std::setprecision(2) << result.llr << " ("
+      << std::log(options.beta / (1.0 - options.alpha)) << ", "
+      << std::log((1.0 - options.beta) / options.alpha) << ")" << std::endl;
+}
+#pragma endregion
+
+} // namespace
+
+auto runMatch(std::ostream &out, const MatchOptions &options) -> MatchResult {
+  const size_t pairs = (options.games + 1) / 2, totalGames = 2 * pairs;
+  const std::vector<Opening> openings = loadOpenings(options, pairs);
+  const unsigned concurrency =
+      options.concurrency ? options.concurrency
+                          : std::max(1U, std::thread::hardware_concurrency());
+
+  chess::search::SearchLimits limits{.depth = chess::search::MAX_PLY - 1,
+                                     .nodes = options.nodes,
+                                     .moveTime = options.moveTime};
+  if (options.depth > 0)
+    limits.depth = std::min(options.depth, limits.depth);
+  if (!options.depth && !options.nodes && !options.moveTime.count())
+    limits.nodes = DEFAULT_MATCH_NODES;
+
+  // Loaded once and shared by every game.
+  std::array<std::shared_ptr<const chess::nnue::Network>, 2> networks;
+  for (size_t side = 0; side < 2; ++side) {
+    if (!options.engines[side].networkFile.empty())
+      networks[side] =
+          chess::nnue::Network::load(options.engines[side].networkFile);
+  }
+
+  std::ofstream pgn;
+  if (!options.pgnFile.empty()) {
+    pgn.open(options.pgnFile);
+    if (!pgn)
+      throw std::logic_error("Cannot write games to " + options.pgnFile);
+  }
+
+  out << options.engines[0].name << " vs " << options.engines[1].name << ", "
+      << totalGames << " games on " << concurrency << " threads" << std::endl;
+
+  MatchResult result;
+  std::mutex mutex;
+  std::atomic<size_t> nextGame{0};
+  std::atomic<bool> finished{false};
+  const size_t reportInterval = std::max<size_t>(2, totalGames / 50);
+
+  const auto runWorker = [&] {
+    // Each worker has its own pair of engines, reused from game to game.
+    std::array<std::unique_ptr<chess::engine::Engine>, 2> engines;
+    for (size_t side = 0; side < 2; ++side) {
+      engines[side] = std::make_unique<chess::engine::Engine>();
+      engines[side]->setHashSize(options.engines[side].hashMegabytes);
+      engines[side]->setSelectivityParams(options.engines[side].selectivity);
+      engines[side]->setNetwork(networks[side]);
+    }
+
+    while (!finished.load(std::memory_order_relaxed)) {
+      const size_t index = nextGame.fetch_add(1);
+      if (index >= totalGames)
+        break;
+      // Each opening twice, the first engine playing white in one game and
+      // black in the other.
+      const size_t first = index % 2;
+      Game game{&openings[(index / 2) % openings.size()], {}, {}};
+      game.players = {&options.engines[first], &options.engines[first ^ 1]};
+      playGame(game, {engines[first].get(), engines[first ^ 1].get()},
+               options, limits);
+
+      std::lock_guard lock(mutex);
+      if (game.outcome == Outcome::DRAW)
+        ++result.draws;
+      else if ((game.outcome == Outcome::WHITE_WINS) == (first == 0))
+        ++result.wins;
+      else
+        ++result.losses;
+      const size_t played = result.wins + result.draws + result.losses;
+      if (pgn.is_open())
+        writePgn(pgn, game, index + 1);
+
+      updateStatistics(result, options);
+      if (result.sprtDecision)
+        finished.store(true, std::memory_order_relaxed);
+      // The last status is written once all workers are done.
+      if (played % reportInterval == 0 && played < totalGames &&
+          !result.sprtDecision)
+        writeStatus(out, result, options, totalGames);
+    }
+  };
+
+  std::vector<std::thread> workers;
+  for (unsigned worker = 0; worker < concurrency; ++worker)
+    workers.emplace_back(runWorker);
+  for (std::thread &worker : workers)
+    worker.join();
+
+  // Games still running when the test stopped count too.
+  updateStatistics(result, options);
+  writeStatus(out, result, options, totalGames);
+  out << (result.sprtDecision > 0   ? "H1 accepted"
+          : result.sprtDecision < 0 ? "H0 accepted"
+                                    : "Inconclusive")
+      << ": elo0 " << options.elo0 << ", elo1 " << options.elo1 << std::endl;
+  return result;
+}
+
+auto parseMatchArguments(const std::span<const std::string_view> words)
+    -> MatchOptions {
+  MatchOptions options;
+  const auto parse = [](const std::string_view value, auto &target) {
+    std::from_chars(value.data(), value.data() + value.size(), target);
+  };
+  for (const std::string_view word : words) {
+    const size_t equals = word.find('=');
+    if (equals == std::string_view::npos)
+      continue;
+    std::string_view key = word.substr(0, equals);
+    const std::string_view value = word.substr(equals + 1);
+
+    if (key.starts_with("first.") || key.starts_with("second.")) {
+      EngineConfig &engine = options.engines[key.starts_with("first.") ? 0 : 1];
+      key.remove_prefix(key.find('.') + 1);
+      if (key == "name")
+        engine.name = value;
+      else if (key == "evalfile")
+        engine.networkFile = value;
+      else if (key == "hash")
+        parse(value, engine.hashMegabytes);
+      const auto parseField = [&](const auto &fields) {
+        for (const auto &[name, field, min, max] : fields) {
+          if (key == name) {
+            parse(value, engine.selectivity.*field);
+            engine.selectivity.*field =
+                std::clamp(engine.selectivity.*field, min, max);
+          }
+        }
+      };
+      parseField(chess::search::SELECTIVITY_INT_FIELDS);
+      parseField(chess::search::SELECTIVITY_FLOAT_FIELDS);
+    } else if (key == "games") {
+      parse(value, options.games);
+    } else if (key == "concurrency") {
+      parse(value, options.concurrency);
+    } else if (key == "openings") {
+      options.openingsFile = value;
+    } else if (key == "plies") {
+      parse(value, options.randomOpeningPlies);
+    } else if (key == "seed") {
+      parse(value, options.seed);
+    } else if (key == "depth") {
+      parse(value, options.depth);
+    } else if (key == "nodes") {
+      parse(value, options.nodes);
+    } else if (key == "movetime") {
+      int64_t milliseconds = 0;
+      parse(value, milliseconds);
+      options.moveTime = std::chrono::milliseconds(milliseconds);
+    } else if (key == "pgn") {
+      options.pgnFile = value;
+    } else if (key == "maxply") {
+      parse(value, options.maxPly);
+    } else if (key == "elo0") {
+      parse(value, options.elo0);
+    } else if (key == "elo1") {
+      parse(value, options.elo1);
+    } else if (key == "alpha") {
+      parse(value, options.alpha);
+    } else if (key == "beta") {
+      parse(value, options.beta);
+    }
+  }
+  return options;
+}
+
+} // namespace chess::match
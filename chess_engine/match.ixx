@@ -0,0 +1,92 @@
+module;
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+
+export module chess.match;
+
+import chess.search;
+import chess.selfplay;
+
+export namespace chess::match {
+
+// One side of a match. Both run in this binary, so they differ in what can
+// be configured at run time: the evaluation, the table size and the search
+// margins.
+export struct EngineConfig {
+  std::string name;
+  // The hand-written evaluation when empty.
+  std::string networkFile;
+  size_t hashMegabytes = 16;
+  chess::search::SelectivityParams selectivity{};
+};
+
+// Used when no limit is given at all.
+export inline constexpr uint64_t DEFAULT_MATCH_NODES = 20'000;
+
+export struct MatchOptions {
+  // The first engine is the one under test: results, Elo and the SPRT are
+  // all from its point of view.
+  std::array<EngineConfig, 2> engines{EngineConfig{.name = "first"},
+                                      EngineConfig{.name = "second"}};
+
+  // One FEN or EPD per line, each played twice with the colors reversed.
+  // Without a file, each pair starts from its own few random moves.
+  std::string openingsFile;
+  int randomOpeningPlies = 8;
+  uint64_t seed = 1;
+
+  // Rounded up to whole pairs.
+  size_t games = 1000;
+  // Games played at once; every core when 0.
+  unsigned concurrency = 0;
+
+  // Per move, any combination; zero for none.
+  int depth = 0;
+  uint64_t nodes = 0;
+  std::chrono::milliseconds moveTime{0};
+
+  // On the scores of both engines.
+  chess::selfplay::AdjudicationParams adjudication{};
+  // Drawn when reached, whatever the position.
+  int maxPly = 400;
+
+  // Every game in PGN, in the order they finish; none when empty.
+  std::string pgnFile;
+
+  // Sequential probability ratio test of elo0 against elo1, stopping the
+  // match as soon as either is accepted at error rates alpha and beta.
+  double elo0 = 0.0, elo1 = 5.0, alpha = 0.05, beta = 0.05;
+};
+
+export struct MatchResult {
+  uint64_t wins = 0, draws = 0, losses = 0;
+  double elo = 0.0, eloMargin = 0.0; // 95% confidence
+  double llr = 0.0;
+  // +1 when elo1 was accepted, -1 when elo0 was, 0 when the games ran out
+  // first.
+  int sprtDecision = 0;
+};
+
+// Plays the two engines against each other, several games at a time, and
+// reports the running score, Elo estimate and SPRT state to `out`. Throws
+// std::logic_error if a file cannot be read or written.
+export auto runMatch(std::ostream &out, const MatchOptions &options)
+    -> MatchResult;
+
+// Reads the words after `match`, all of the form key=value: games,
+// concurrency, openings, plies, seed, depth, nodes, movetime, pgn, maxply,
+// elo0, elo1, alpha and beta, and per engine first.<key> and second.<key>
+// for name, evalfile, hash and every SelectivityParams field, clamped to
+// its range in chess::search::SELECTIVITY_INT_FIELDS or
+// SELECTIVITY_FLOAT_FIELDS. Unknown words are ignored.
+export auto parseMatchArguments(std::span<const std::string_view> words)
+    -> MatchOptions;
+
+} // namespace chess::match
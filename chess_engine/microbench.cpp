@@ -0,0 +1,279 @@
+module;
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <ostream>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+module chess.microbench;
+
+import chess.core;
+import chess.board_state;
+import chess.move;
+import chess.fen;
+import chess.attack_map;
+import chess.bench;
+import chess.evaluation;
+import chess.batch_evaluation;
+import chess.move_executor;
+import chess.move_generator;
+import chess.generator_helpers;
+
+namespace chess::microbench {
+
+using chess::board::Bitboard;
+using chess::board::BoardState;
+using chess::board::Move;
+using chess::board::MoveList;
+
+namespace {
+
+// A pass over the corpus returns how many operations it timed and a
+// checksum of their results, which ends up in `sink` so nothing can be
+// optimized away.
+using Pass = std::function<uint64_t(std::span<const BoardState>, uint64_t &)>;
+
+struct Benchmark {
+  std::string_view name;
+  Pass pass;
+};
+
+struct Summary {
+  double min, median, mean, stddev;
+};
+
+volatile uint64_t sink;
+
+// Read through a volatile pointer before every pass, so the compiler cannot
+// assume two passes see the same positions and fold them into one.
+const BoardState *volatile corpusData;
+
+Summary summarize(std::vector<double> samples) {
+  std::sort(samples.begin(), samples.end());
+  const size_t count = samples.size();
+  const double mean =
+      std::accumulate(samples.begin(), samples.end(), 0.0) / count;
+  double squares = 0.0;
+  for (const double sample : samples)
+    squares += (sample - mean) * (sample - mean);
+  return {samples.front(),
+          count % 2 ? samples[count / 2]
+                    : (samples[count / 2 - 1] + samples[count / 2]) / 2,
+          mean, count > 1 ? std::sqrt(squares / (count - 1)) : 0.0};
+}
+
+// Every move of every position, generated up front so that doMove is timed
+// alone.
+std::vector<std::pair<size_t, Move>>
+getCorpusMoves(std::span<const BoardState> corpus) {
+  std::vector<std::pair<size_t, Move>> corpusMoves;
+  MoveList moves;
+  for (size_t i = 0; i < corpus.size(); ++i) {
+    chess::move_generator::getPossibleMoves(corpus[i], moves);
+    for (const Move &move : moves)
+      corpusMoves.emplace_back(i, move);
+  }
+  return corpusMoves;
+}
+
+// The corpus in the layout evaluateBatch reads, built up front for the same
+// reason.
+chess::evaluation::PositionBatch
+getCorpusBatch(std::span<const BoardState> corpus) {
+  chess::evaluation::PositionBatch batch;
+  batch.reserve(corpus.size());
+  for (const BoardState &boardState : corpus)
+    batch.add(boardState);
+  return batch;
+}
+
+std::vector<Benchmark> getBenchmarks(std::span<const BoardState> corpus) {
+  using namespace chess::move_generator;
+  return {
+      {"getPossibleMoves",
+       [](std::span<const BoardState> corpus, uint64_t &checksum) {
+         MoveList moves;
+         for (const BoardState &boardState : corpus) {
+           getPossibleMoves(boardState, moves);
+           checksum += moves.size();
+         }
+         return static_cast<uint64_t>(corpus.size());
+       }},
+      {"getThreatSquares",
+       [](std::span<const BoardState> corpus, uint64_t &checksum) {
+         for (const BoardState &boardState : corpus)
+           checksum += getThreatSquares(boardState.getTurnColor(), boardState);
+         return static_cast<uint64_t>(corpus.size());
+       }},
+      {"buildAttackMap",
+       [](std::span<const BoardState> corpus, uint64_t &checksum) {
+         for (const BoardState &boardState : corpus)
+           checksum += chess::move_generator::buildAttackMap(boardState)
+                           .multiple[0];
+         return static_cast<uint64_t>(corpus.size());
+       }},
+      {"doMove",
+       [moves = getCorpusMoves(corpus)](std::span<const BoardState> corpus,
+                                        uint64_t &checksum) {
+         // Copy-make: the copy is the undo, so it is timed along with it.
+         for (const auto &[position, move] : moves) {
+           BoardState next = corpus[position];
+           chess::move_executor::doMove(next, move);
+           checksum += next.getHash();
+         }
+         return static_cast<uint64_t>(moves.size());
+       }},
+      {"getPieceInfo",
+       [](std::span<const BoardState> corpus, uint64_t &checksum) {
+         for (const BoardState &boardState : corpus) {
+           for (uint8_t index = 0; index < 64; ++index) {
+             if (auto pieceInfo = boardState.getPieceInfo(1ULL << index))
+               checksum += static_cast<uint64_t>(pieceInfo->name);
+           }
+         }
+         return corpus.size() * 64;
+       }},
+      {"getEmpty",
+       [](std::span<const BoardState> corpus, uint64_t &checksum) {
+         for (const BoardState &boardState : corpus)
+           checksum += boardState.getEmpty();
+         return static_cast<uint64_t>(corpus.size());
+       }},
+      {"evaluate",
+       [](std::span<const BoardState> corpus, uint64_t &checksum) {
+         for (const BoardState &boardState : corpus)
+           checksum += chess::evaluation::evaluate(boardState);
+         return static_cast<uint64_t>(corpus.size());
+       }},
+      {"evaluateStatic",
+       [](std::span<const BoardState> corpus, uint64_t &checksum) {
+         for (const BoardState &boardState : corpus)
+           checksum += chess::evaluation::evaluateStatic(boardState);
+         return static_cast<uint64_t>(corpus.size());
+       }},
+      {"evaluateBatch",
+       [batch = getCorpusBatch(corpus),
+        scores = std::vector<int>(corpus.size())](
+           std::span<const BoardState>, uint64_t &checksum) mutable {
+         chess::evaluation::evaluateBatch(batch, scores);
+         for (const int score : scores)
+           checksum += score;
+         return static_cast<uint64_t>(batch.size());
+       }},
+      // The hyperbola quintessence lookups are internal; these are their
+      // two public callers, each made of two of them.
+      {"getBishopAttacks",
+       [](std::span<const BoardState> corpus, uint64_t &checksum) {
+         for (const BoardState &boardState : corpus) {
+           const Bitboard empty = boardState.getEmpty();
+           for (uint8_t index = 0; index < 64; ++index)
+             checksum += getBishopAttacks(index, empty);
+         }
+         return corpus.size() * 64;
+       }},
+      {"getRookAttacks",
+       [](std::span<const BoardState> corpus, uint64_t &checksum) {
+         for (const BoardState &boardState : corpus) {
+           const Bitboard empty = boardState.getEmpty();
+           for (uint8_t index = 0; index < 64; ++index)
+             checksum += getRookAttacks(index, empty);
+         }
+         return corpus.size() * 64;
+       }},
+      {"getNextPiece",
+       [](std::span<const BoardState> corpus, uint64_t &checksum) {
+         uint64_t count = 0;
+         for (const BoardState &boardState : corpus) {
+           Bitboard occupied = ~boardState.getEmpty();
+           while (auto piece = chess::board::getNextPiece(occupied)) {
+             checksum += piece->index;
+             ++count;
+           }
+         }
+         return count;
+       }},
+  };
+}
+
+// Runs `pass` over the corpus `iterations` times; returns nanoseconds per
+// operation.
+double timeSample(const Pass &pass, const size_t corpusSize,
+                  const size_t iterations) {
+  uint64_t checksum = 0, operations = 0;
+  const auto start = std::chrono::steady_clock::now();
+  for (size_t i = 0; i < iterations; ++i)
+    operations += pass({corpusData, corpusSize}, checksum);
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+  sink = sink + checksum;
+  return std::chrono::duration<double, std::nano>(elapsed).count() /
+         static_cast<double>(operations);
+}
+
+// Doubles the iteration count until a sample lasts long enough.
+size_t calibrate(const Pass &pass, const size_t corpusSize,
+                 const double minSampleMilliseconds) {
+  size_t iterations = 1;
+  while (true) {
+    const auto start = std::chrono::steady_clock::now();
+    timeSample(pass, corpusSize, iterations);
+    const double milliseconds = std::chrono::duration<double, std::milli>(
+                                    std::chrono::steady_clock::now() - start)
+                                    .count();
+    if (milliseconds >= minSampleMilliseconds)
+      return iterations;
+    iterations *= 2;
+  }
+}
+
+} // namespace
+
+void runMicrobenchmarks(std::ostream &out, const MicrobenchOptions &options) {
+  if (options.repetitions == 0)
+    throw std::logic_error("Microbenchmarks need at least one repetition");
+
+  std::vector<BoardState> corpus;
+  for (const std::string_view fen : chess::bench::BENCH_POSITIONS) {
+    const auto position = chess::board::parseFen(fen);
+    if (!position)
+      throw std::logic_error("Invalid bench position");
+    corpus.push_back(*position);
+  }
+  corpusData = corpus.data();
+
+  out << "{\n  \"corpus_positions\": " << corpus.size()
+      << ",\n  \"warmup_runs\": " << options.warmupRuns
+      << ",\n  \"repetitions\": " << options.repetitions
+      << ",\n  \"benchmarks\": [";
+
+  const std::vector<Benchmark> benchmarks = getBenchmarks(corpus);
+  for (size_t i = 0; i < benchmarks.size(); ++i) {
+    const Benchmark &benchmark = benchmarks[i];
+    const size_t iterations = calibrate(benchmark.pass, corpus.size(),
+                                        options.minSampleMilliseconds);
+    for (size_t run = 0; run < options.warmupRuns; ++run)
+      timeSample(benchmark.pass, corpus.size(), iterations);
+
+    std::vector<double> samples;
+    for (size_t run = 0; run < options.repetitions; ++run)
+      samples.push_back(timeSample(benchmark.pass, corpus.size(), iterations));
+    const Summary summary = summarize(std::move(samples));
+
+    out << (i ? ",\n" : "\n") << "    {\"name\": \"" << benchmark.name
+        << "\", \"iterations\": " << iterations
+        << ", \"ns_per_op\": {\"min\": " << summary.min
+        << ", \"median\": " << summary.median << ", \"mean\": " << summary.mean
+        << ", \"stddev\": " << summary.stddev << "}}";
+  }
+  out << "\n  ]\n}" << std::endl;
+}
+
+} // namespace chess::microbench
@@ -0,0 +1,24 @@
+module;
+
+#include <cstddef>
+#include <ostream>
+
+export module chess.microbench;
+
+export namespace chess::microbench {
+
+export struct MicrobenchOptions {
+  size_t warmupRuns = 3;
+  size_t repetitions = 15;
+  // Each timed sample repeats its pass over the corpus until it lasts at
+  // least this long, so timer resolution stays negligible.
+  double minSampleMilliseconds = 20.0;
+};
+
+// Times the move generator, the move executor and the board primitives one
+// by one over the bench positions, and writes the per-operation timings as
+// JSON to `out` so runs from different commits can be compared.
+export void runMicrobenchmarks(std::ostream &out,
+                               const MicrobenchOptions &options = {});
+
+} // namespace chess::microbench
@@ -122,4 +122,32 @@ export struct Move {
   }
 };
 
+// Fixed capacity move container, so generating moves never allocates. No
+// position has more than 218 legal moves; pseudo-legal ones stay well below
+// the capacity too.
+export class MoveList {
+public:
+  static constexpr size_t CAPACITY = 256;
+
+private:
+  std::array<Move, CAPACITY> moves_;
+  size_t size_ = 0;
+
+public:
+  void push_back(const Move &move) { moves_[size_++] = move; }
+  void clear() { size_ = 0; }
+
+  [[nodiscard]] size_t size() const { return size_; }
+  [[nodiscard]] bool empty() const { return size_ == 0; }
+  [[nodiscard]] Move &operator[](size_t index) { return moves_[index]; }
+  [[nodiscard]] const Move &operator[](size_t index) const {
+    return moves_[index];
+  }
+
+  [[nodiscard]] Move *begin() { return moves_.data(); }
+  [[nodiscard]] Move *end() { return moves_.data() + size_; }
+  [[nodiscard]] const Move *begin() const { return moves_.data(); }
+  [[nodiscard]] const Move *end() const { return moves_.data() + size_; }
+};
+
 } // namespace chess::board
\ No newline at end of file
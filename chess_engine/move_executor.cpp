@@ -142,6 +142,14 @@ void doMove(chess::board::BoardState &boardState,
   }
   const chess::board::Name movedPieceName = *movedPieceNameOpt;
 
+  // Pawn moves and captures cannot be undone, so positions before them can
+  // never repeat; the fifty-move rule counts from the last one.
+  if (movedPieceName == chess::board::Name::PAWN ||
+      (endBoard & ~boardState.getEmpty()))
+    boardState.resetHalfmoveClock();
+  else
+    boardState.incrementHalfmoveClock();
+
   // 2. Handle En Passant Capture (removes the captured pawn) and updates the en
   // passant square for the *next* turn.
   handleEnPassant(boardState, startBoard, endBoard, moveType);
@@ -1,5 +1,6 @@
 module;
 
+#include <bit>
 #include <vector>
 
 module chess.move_generator;
@@ -7,6 +8,7 @@ module chess.move_generator;
 import chess.core;
 import chess.board_state;
 import chess.move;
+import chess.move_executor;
 import chess.masks;
 import chess.generator_helpers;
 
@@ -14,8 +16,14 @@ namespace chess::move_generator {
 
 auto getPossibleMoves(const chess::board::BoardState &boardState)
     -> std::vector<chess::board::Move> {
-  std::vector<chess::board::Move> moveList;
-  moveList.reserve(256); // Reserve capacity to avoid reallocations.
+  chess::board::MoveList moveList;
+  getPossibleMoves(boardState, moveList);
+  return {moveList.begin(), moveList.end()};
+}
+
+auto getPossibleMoves(const chess::board::BoardState &boardState,
+                      chess::board::MoveList &moveList) -> void {
+  moveList.clear();
 
   const chess::board::Color color = boardState.getTurnColor(),
                             otherColor = getOppositeColor(color);
@@ -51,7 +59,7 @@ auto getPossibleMoves(const chess::board::BoardState &boardState)
   KingGenerator kingGenerator({.moveList = moveList,
                                .boardState = boardState,
                                .kings = boardState.getPieces(color, Name::KING),
-                               .threats = getThreatSquares(color, boardState),
+                               .threats = getThreatSquares(otherColor, boardState),
                                .castles = boardState.castles_});
 
   // --- Generate Moves ---
@@ -68,8 +76,62 @@ auto getPossibleMoves(const chess::board::BoardState &boardState)
   pawnGenerator.addPushOnceTargets();          // pawns
   kingGenerator.addKingTargets();              // kings
   kingGenerator.addCastleTargets();            // kings
+}
+
+auto getThreatSquares(const chess::board::Color color,
+                      const chess::board::BoardState &boardState)
+    -> chess::board::Bitboard {
+  using chess::board::Name;
+
+  chess::board::Bitboard
+      knights = boardState.getPieces(color, Name::KNIGHT),
+      diagonalSliders = boardState.getPieces(color, Name::BISHOP) |
+                        boardState.getPieces(color, Name::QUEEN),
+      orthogonalSliders = boardState.getPieces(color, Name::ROOK) |
+                          boardState.getPieces(color, Name::QUEEN),
+      kings = boardState.getPieces(color, Name::KING),
+      allThreats =
+          getPawnAttacks(color, boardState.getPieces(color, Name::PAWN));
+  const chess::board::Bitboard empty = boardState.getEmpty();
+
+  while (auto pieceInfo = chess::board::getNextPiece(knights))
+    allThreats |= getKnightAttacks(pieceInfo->index);
+
+  while (auto pieceInfo = chess::board::getNextPiece(diagonalSliders))
+    allThreats |= getBishopAttacks(pieceInfo->index, empty);
+
+  while (auto pieceInfo = chess::board::getNextPiece(orthogonalSliders))
+    allThreats |= getRookAttacks(pieceInfo->index, empty);
+
+  while (auto pieceInfo = chess::board::getNextPiece(kings))
+    allThreats |= getKingAttacks(pieceInfo->index);
+
+  return allThreats;
+}
+
+auto isInCheck(const chess::board::Color color,
+               const chess::board::BoardState &boardState) -> bool {
+  // Only the pieces attacking the king matter, not every threatened square.
+  const chess::board::Bitboard king =
+      boardState.getPieces(color, chess::board::Name::KING);
+  if (!king)
+    return false;
+  return getAttackersTo(boardState, std::countr_zero(king),
+                        ~boardState.getEmpty()) &
+         boardState.getPieces(chess::board::getOppositeColor(color));
+}
 
-  return moveList;
+auto getLegalMoves(const chess::board::BoardState &boardState,
+                   chess::board::MoveList &legalMoves) -> void {
+  chess::board::MoveList moves;
+  getPossibleMoves(boardState, moves);
+  legalMoves.clear();
+  for (const chess::board::Move &move : moves) {
+    chess::board::BoardState next = boardState;
+    chess::move_executor::doMove(next, move);
+    if (!isInCheck(boardState.getTurnColor(), next))
+      legalMoves.push_back(move);
+  }
 }
 
 } // namespace chess::move_generator
\ No newline at end of file
@@ -9,10 +9,18 @@ import <vector>;
 
 export namespace chess::move_generator {
 
+export auto getPossibleMoves(const chess::board::BoardState &boardState,
+                              chess::board::MoveList &moveList) -> void;
 export auto getPossibleMoves(const chess::board::BoardState &boardState)
     -> std::vector<chess::board::Move>;
 export auto getThreatSquares(const chess::board::Color color,
                              const chess::board::BoardState &boardState)
     -> chess::board::Bitboard;
+export auto isInCheck(const chess::board::Color color,
+                      const chess::board::BoardState &boardState) -> bool;
+// The pseudo-legal moves that do not leave the mover's king in check. Too
+// slow for the search, which rejects illegal moves as it plays them.
+export auto getLegalMoves(const chess::board::BoardState &boardState,
+                          chess::board::MoveList &legalMoves) -> void;
 
 } // namespace chess::move_generator
\ No newline at end of file
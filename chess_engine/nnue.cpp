@@ -0,0 +1,389 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+#if defined(__AVX2__) && !defined(CHESS_NO_SIMD)
+#define CHESS_NNUE_AVX2
+#include <immintrin.h>
+#endif
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+module chess.nnue;
+
+import chess.core;
+import chess.board_state;
+
+namespace chess::nnue {
+
+using chess::board::Bitboard;
+using chess::board::BoardState;
+using chess::board::Color;
+using chess::board::Name;
+
+auto getKingTransform(const Color perspective, const uint8_t kingSquare)
+    -> uint8_t {
+  // Rank 8 is index 0, so flipping ranks makes black's first rank 7 as well.
+  const uint8_t relative =
+      perspective == Color::WHITE ? kingSquare : kingSquare ^ 56;
+  const int rank = 7 - relative / 8;
+  const uint8_t bucket = rank == 0 ? 0 : rank == 1 ? 1 : rank <= 3 ? 2 : 3;
+  const bool mirrored = relative % 8 >= 4;
+  return static_cast<uint8_t>(bucket | (mirrored ? 4 : 0));
+}
+
+namespace {
+
+#pragma region file_mapping
+struct Mapping {
+  const std::byte *data;
+  size_t size;
+};
+
+std::optional<Mapping> mapFile(const std::string &path) {
+#ifdef _WIN32
+  const HANDLE file =
+      CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                  OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE)
+    return std::nullopt;
+  LARGE_INTEGER size;
+  const HANDLE mapping =
+      GetFileSizeEx(file, &size) && size.QuadPart > 0
+          ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)
+          : nullptr;
+  CloseHandle(file);
+  if (!mapping)
+    return std::nullopt;
+  // The view keeps the mapping alive on its own.
+  const void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  CloseHandle(mapping);
+  if (!view)
+    return std::nullopt;
+  return Mapping{static_cast<const std::byte *>(view),
+                 static_cast<size_t>(size.QuadPart)};
+#else
+  const int file = open(path.c_str(), O_RDONLY);
+  if (file < 0)
+    return std::nullopt;
+  struct stat status;
+  void *view = fstat(file, &status) == 0 && status.st_size > 0
+                   ? mmap(nullptr, static_cast<size_t>(status.st_size),
+                          PROT_READ, MAP_PRIVATE, file, 0)
+                   : MAP_FAILED;
+  close(file);
+  if (view == MAP_FAILED)
+    return std::nullopt;
+  return Mapping{static_cast<const std::byte *>(view),
+                 static_cast<size_t>(status.st_size)};
+#endif
+}
+
+void unmapFile(const Mapping &mapping) {
+#ifdef _WIN32
+  UnmapViewOfFile(mapping.data);
+#else
+  munmap(const_cast<std::byte *>(mapping.data), mapping.size);
+#endif
+}
+
+uint32_t readUint32(const std::byte *data) {
+  uint32_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+#pragma endregion
+
+#pragma region kernels
+// All kernels work on whole accumulators of HIDDEN_SIZE values.
+
+void addColumn(int16_t *values, const int16_t *column) {
+#ifdef CHESS_NNUE_AVX2
+  for (size_t i = 0; i < HIDDEN_SIZE; i += 16) {
+    const __m256i sum = _mm256_add_epi16(
+        _mm256_load_si256(reinterpret_cast<const __m256i *>(values + i)),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(column + i)));
+    _mm256_store_si256(reinterpret_cast<__m256i *>(values + i), sum);
+  }
+#else
+  for (size_t i = 0; i < HIDDEN_SIZE; ++i)
+    values[i] += column[i];
+#endif
+}
+
+void subtractColumn(int16_t *values, const int16_t *column) {
+#ifdef CHESS_NNUE_AVX2
+  for (size_t i = 0; i < HIDDEN_SIZE; i += 16) {
+    const __m256i difference = _mm256_sub_epi16(
+        _mm256_load_si256(reinterpret_cast<const __m256i *>(values + i)),
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(column + i)));
+    _mm256_store_si256(reinterpret_cast<__m256i *>(values + i), difference);
+  }
+#else
+  for (size_t i = 0; i < HIDDEN_SIZE; ++i)
+    values[i] -= column[i];
+#endif
+}
+
+// Dot product of the clipped accumulator with int8 weights.
+int32_t clippedDot(const int16_t *values, const int8_t *weights) {
+#ifdef CHESS_NNUE_AVX2
+  const __m256i zero = _mm256_setzero_si256(),
+                ceiling = _mm256_set1_epi16(ACTIVATION_SCALE),
+                ones = _mm256_set1_epi16(1);
+  __m256i sum = _mm256_setzero_si256();
+  for (size_t i = 0; i < HIDDEN_SIZE; i += 32) {
+    const __m256i low = _mm256_min_epi16(
+        _mm256_max_epi16(
+            _mm256_load_si256(reinterpret_cast<const __m256i *>(values + i)),
+            zero),
+        ceiling);
+    const __m256i high = _mm256_min_epi16(
+        _mm256_max_epi16(_mm256_load_si256(
+                             reinterpret_cast<const __m256i *>(values + i + 16)),
+                         zero),
+        ceiling);
+    // Packing interleaves the 128 bit lanes; put them back in order.
+    const __m256i activations =
+        _mm256_permute4x64_epi64(_mm256_packus_epi16(low, high), 0xD8);
+    // Pairs of 127 * 128 stay within int16, so this cannot saturate.
+    const __m256i products = _mm256_maddubs_epi16(
+        activations,
+        _mm256_loadu_si256(reinterpret_cast<const __m256i *>(weights + i)));
+    sum = _mm256_add_epi32(sum, _mm256_madd_epi16(products, ones));
+  }
+  const __m128i quarter =
+      _mm_add_epi32(_mm256_castsi256_si128(sum),
+                    _mm256_extracti128_si256(sum, 1));
+  const __m128i half =
+      _mm_add_epi32(quarter, _mm_shuffle_epi32(quarter, 0x4E));
+  return _mm_cvtsi128_si32(_mm_add_epi32(half, _mm_shuffle_epi32(half, 0xB1)));
+#else
+  int32_t sum = 0;
+  for (size_t i = 0; i < HIDDEN_SIZE; ++i)
+    sum += std::clamp<int32_t>(values[i], 0, ACTIVATION_SCALE) * weights[i];
+  return sum;
+#endif
+}
+#pragma endregion
+
+#pragma region features
+size_t getFeature(const Color perspective, const uint8_t transform,
+                  const uint8_t piece, const uint8_t square) {
+  const Color color = static_cast<Color>(piece / 6);
+  uint8_t relative = perspective == Color::WHITE ? square : square ^ 56;
+  if (transform & 4)
+    relative ^= 7;
+  const size_t kind = (color == perspective ? 0 : 6) + piece % 6;
+  return ((transform & 3) * 12 + kind) * 64 + relative;
+}
+
+std::array<uint8_t, 2> getTransforms(const BoardState &boardState) {
+  std::array<uint8_t, 2> transforms{};
+  for (const Color color : {Color::WHITE, Color::BLACK}) {
+    const Bitboard king = boardState.getPieces(color, Name::KING);
+    transforms[static_cast<size_t>(color)] =
+        king ? getKingTransform(color,
+                                static_cast<uint8_t>(std::countr_zero(king)))
+             : 0;
+  }
+  return transforms;
+}
+#pragma endregion
+
+} // namespace
+
+#pragma region network
+auto Network::load(const std::string &path)
+    -> std::shared_ptr<const Network> {
+  const std::optional<Mapping> mapping = mapFile(path);
+  if (!mapping)
+    throw std::logic_error("Cannot map network file " + path);
+
+  std::shared_ptr<Network> network(new Network());
+  network->mapping_ = mapping->data;
+  network->mappingSize_ = mapping->size;
+
+  const std::byte *data = mapping->data;
+  if (mapping->size != NETWORK_FILE_SIZE ||
+      std::memcmp(data, NETWORK_MAGIC.data(), NETWORK_MAGIC.size()) != 0 ||
+      readUint32(data + 4) != NETWORK_VERSION ||
+      readUint32(data + 8) != INPUT_SIZE ||
+      readUint32(data + 12) != HIDDEN_SIZE)
+    throw std::logic_error("Not a network of this engine: " + path);
+
+  data += NETWORK_HEADER_SIZE;
+  network->featureWeights_ = reinterpret_cast<const int16_t *>(data);
+  data += INPUT_SIZE * HIDDEN_SIZE * sizeof(int16_t);
+  network->featureBiases_ = reinterpret_cast<const int16_t *>(data);
+  data += HIDDEN_SIZE * sizeof(int16_t);
+  network->outputWeights_ = reinterpret_cast<const int8_t *>(data);
+  data += 2 * HIDDEN_SIZE;
+  network->outputBias_ = static_cast<int32_t>(readUint32(data));
+  return network;
+}
+
+Network::~Network() {
+  if (mapping_)
+    unmapFile({mapping_, mappingSize_});
+}
+
+auto loadDefaultNetwork() -> std::shared_ptr<const Network> {
+  try {
+    return Network::load(std::string(DEFAULT_NETWORK_FILE));
+  } catch (const std::logic_error &) {
+    return nullptr;
+  }
+}
+
+int Network::evaluate(const int16_t *us, const int16_t *them) const {
+  const int64_t output = static_cast<int64_t>(clippedDot(us, outputWeights_)) +
+                         clippedDot(them, outputWeights_ + HIDDEN_SIZE) +
+                         outputBias_;
+  return static_cast<int>(std::clamp<int64_t>(
+      output * OUTPUT_SCALE / (ACTIVATION_SCALE * WEIGHT_SCALE), -MAX_SCORE,
+      MAX_SCORE));
+}
+#pragma endregion
+
+#pragma region accumulator_stack
+void AccumulatorStack::reset(const BoardState &root) {
+  top_ = 0;
+  Entry &entry = entries_[0];
+  entry.computed = {false, false};
+  entry.needsRefresh = {true, true};
+  entry.transforms = getTransforms(root);
+  entry.removedCount = entry.addedCount = 0;
+}
+
+void AccumulatorStack::push(const BoardState &parent, const BoardState &child) {
+  if (top_ + 1 >= CAPACITY)
+    throw std::logic_error("Search path too long for the accumulator stack");
+  const Entry &previous = entries_[top_];
+  Entry &entry = entries_[++top_];
+  entry.computed = {false, false};
+  entry.transforms = getTransforms(child);
+  entry.removedCount = entry.addedCount = 0;
+  bool overflowed = false;
+
+  // The pieces that differ between the two boards, which for a move are
+  // the mover, whatever it captured and the castling rook.
+  for (const Color color : {Color::WHITE, Color::BLACK}) {
+    for (size_t name = 0; name < static_cast<size_t>(Name::COUNT); ++name) {
+      const Bitboard before = parent.getPieces(color, static_cast<Name>(name)),
+                     after = child.getPieces(color, static_cast<Name>(name));
+      const uint8_t piece =
+          static_cast<uint8_t>(static_cast<size_t>(color) * 6 + name);
+      Bitboard removed = before & ~after, added = after & ~before;
+      while (auto pieceInfo = chess::board::getNextPiece(removed)) {
+        if (entry.removedCount == MAX_CHANGES)
+          overflowed = true;
+        else
+          entry.removed[entry.removedCount++] = {piece, pieceInfo->index};
+      }
+      while (auto pieceInfo = chess::board::getNextPiece(added)) {
+        if (entry.addedCount == MAX_CHANGES)
+          overflowed = true;
+        else
+          entry.added[entry.addedCount++] = {piece, pieceInfo->index};
+      }
+    }
+  }
+
+  for (size_t side = 0; side < 2; ++side)
+    entry.needsRefresh[side] =
+        overflowed || entry.transforms[side] != previous.transforms[side];
+}
+
+void AccumulatorStack::refresh(const Color perspective,
+                               const BoardState &boardState,
+                               const Network &network) {
+  Entry &entry = entries_[top_];
+  const size_t side = static_cast<size_t>(perspective);
+  int16_t *values = entry.values[side].data();
+  std::copy_n(network.getFeatureBiases(), HIDDEN_SIZE, values);
+
+  for (const Color color : {Color::WHITE, Color::BLACK}) {
+    for (size_t name = 0; name < static_cast<size_t>(Name::COUNT); ++name) {
+      const uint8_t piece =
+          static_cast<uint8_t>(static_cast<size_t>(color) * 6 + name);
+      Bitboard pieces = boardState.getPieces(color, static_cast<Name>(name));
+      while (auto pieceInfo = chess::board::getNextPiece(pieces))
+        addColumn(values, network.getFeatureWeights(
+                              getFeature(perspective, entry.transforms[side],
+                                         piece, pieceInfo->index)));
+    }
+  }
+  entry.computed[side] = true;
+}
+
+void AccumulatorStack::update(const Color perspective,
+                              const BoardState &boardState,
+                              const Network &network) {
+  const size_t side = static_cast<size_t>(perspective);
+
+  // Back to the closest computed entry, unless the king moved to a
+  // different bucket on the way, in which case nothing carries over.
+  size_t first = top_;
+  while (!entries_[first].computed[side]) {
+    if (entries_[first].needsRefresh[side]) {
+      refresh(perspective, boardState, network);
+      return;
+    }
+    --first;
+  }
+
+  for (size_t ply = first + 1; ply <= top_; ++ply) {
+    Entry &entry = entries_[ply];
+    int16_t *values = entry.values[side].data();
+    std::copy_n(entries_[ply - 1].values[side].data(), HIDDEN_SIZE, values);
+    for (uint8_t i = 0; i < entry.removedCount; ++i)
+      subtractColumn(values, network.getFeatureWeights(getFeature(
+                                 perspective, entry.transforms[side],
+                                 entry.removed[i].piece,
+                                 entry.removed[i].square)));
+    for (uint8_t i = 0; i < entry.addedCount; ++i)
+      addColumn(values, network.getFeatureWeights(getFeature(
+                            perspective, entry.transforms[side],
+                            entry.added[i].piece, entry.added[i].square)));
+    entry.computed[side] = true;
+  }
+}
+
+int AccumulatorStack::evaluate(const BoardState &boardState,
+                               const Network &network) {
+  update(Color::WHITE, boardState, network);
+  update(Color::BLACK, boardState, network);
+  const Entry &entry = entries_[top_];
+  const size_t us = static_cast<size_t>(boardState.getTurnColor());
+  return network.evaluate(entry.values[us].data(), entry.values[us ^ 1].data());
+}
+
+auto AccumulatorStack::getValues(const Color perspective,
+                                 const BoardState &boardState,
+                                 const Network &network)
+    -> const std::array<int16_t, HIDDEN_SIZE> & {
+  update(perspective, boardState, network);
+  return entries_[top_].values[static_cast<size_t>(perspective)];
+}
+#pragma endregion
+
+} // namespace chess::nnue
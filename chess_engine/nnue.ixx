@@ -0,0 +1,157 @@
+module;
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+
+export module chess.nnue;
+
+import chess.core;
+import chess.board_state;
+
+export namespace chess::nnue {
+
+// Features are king relative: each perspective sees the board from its own
+// side, mirrored so its king is on files a-d, and splits its king's position
+// into buckets by rank. Within a bucket a feature is a piece kind (own
+// pieces first) on a square.
+export inline constexpr size_t KING_BUCKETS = 4;
+export inline constexpr size_t INPUT_SIZE = KING_BUCKETS * 12 * 64;
+export inline constexpr size_t HIDDEN_SIZE = 256;
+
+// Quantization: accumulator values are in units of 1 / ACTIVATION_SCALE and
+// clipped to [0, ACTIVATION_SCALE], output weights in units of
+// 1 / WEIGHT_SCALE. The output is multiplied by OUTPUT_SCALE to get
+// centipawns.
+export inline constexpr int ACTIVATION_SCALE = 127;
+export inline constexpr int WEIGHT_SCALE = 64;
+export inline constexpr int OUTPUT_SCALE = 400;
+// Keeps network scores well away from mate scores.
+export inline constexpr int MAX_SCORE = 30'000;
+
+// Bucket in the low two bits and mirroring in bit 2, for a perspective whose
+// king is on `kingSquare`. Features only carry over while it is unchanged.
+export auto getKingTransform(chess::board::Color perspective,
+                             uint8_t kingSquare) -> uint8_t;
+
+export inline constexpr std::string_view DEFAULT_NETWORK_FILE = "network.nnue";
+
+// Network file layout, little endian, every section starting on a 32 byte
+// boundary so the weights can be used straight from the mapped file:
+//   char[4]  "CHNN"
+//   uint32   version (1), INPUT_SIZE, HIDDEN_SIZE
+//   16 bytes reserved, zero
+//   int16    feature weights [INPUT_SIZE][HIDDEN_SIZE]
+//   int16    feature biases  [HIDDEN_SIZE]
+//   int8     output weights  [2][HIDDEN_SIZE], side to move first
+//   int32    output bias, followed by 28 bytes of padding
+export inline constexpr std::string_view NETWORK_MAGIC = "CHNN";
+export inline constexpr uint32_t NETWORK_VERSION = 1;
+export inline constexpr size_t NETWORK_HEADER_SIZE = 32;
+export inline constexpr size_t NETWORK_FILE_SIZE =
+    NETWORK_HEADER_SIZE + (INPUT_SIZE + 1) * HIDDEN_SIZE * sizeof(int16_t) +
+    2 * HIDDEN_SIZE + 32;
+
+// Weights of one network, mapped read-only from their file and shared by
+// every search thread.
+export class Network {
+private:
+  const std::byte *mapping_ = nullptr;
+  size_t mappingSize_ = 0;
+
+  const int16_t *featureWeights_ = nullptr;
+  const int16_t *featureBiases_ = nullptr;
+  const int8_t *outputWeights_ = nullptr;
+  int32_t outputBias_ = 0;
+
+  Network() = default;
+
+public:
+  // Throws std::logic_error if `path` cannot be mapped or does not hold a
+  // network of the layout above.
+  static auto load(const std::string &path) -> std::shared_ptr<const Network>;
+
+  ~Network();
+  Network(const Network &) = delete;
+  Network &operator=(const Network &) = delete;
+
+  [[nodiscard]] const int16_t *getFeatureWeights(const size_t feature) const {
+    return featureWeights_ + feature * HIDDEN_SIZE;
+  }
+  [[nodiscard]] const int16_t *getFeatureBiases() const {
+    return featureBiases_;
+  }
+
+  // Centipawns for the side whose accumulator is `us`.
+  [[nodiscard]] int evaluate(const int16_t *us, const int16_t *them) const;
+};
+
+// DEFAULT_NETWORK_FILE from the working directory, or null when there is no
+// usable network there.
+export auto loadDefaultNetwork() -> std::shared_ptr<const Network>;
+
+// First layer outputs along the current search path, one entry per ply.
+// Entries are brought up to date lazily, by adding and removing the columns
+// of the pieces that moved since the closest computed ancestor, so positions
+// whose evaluation comes from a cache cost nothing but the bookkeeping.
+export class AccumulatorStack {
+private:
+  // The search ends every line, quiescence included, by MAX_PLY.
+  static constexpr size_t CAPACITY = 128;
+  // A move removes at most two pieces (a capturing promotion) and adds at
+  // most two (castling).
+  static constexpr size_t MAX_CHANGES = 2;
+
+  struct PieceChange {
+    uint8_t piece; // color * 6 + name
+    uint8_t square;
+  };
+
+  struct Entry {
+    alignas(32) std::array<std::array<int16_t, HIDDEN_SIZE>, 2> values;
+    std::array<bool, 2> computed;
+    // The perspective's king bucket and mirroring changed since the parent,
+    // so none of its features carry over.
+    std::array<bool, 2> needsRefresh;
+    std::array<uint8_t, 2> transforms;
+    std::array<PieceChange, MAX_CHANGES> removed, added;
+    uint8_t removedCount, addedCount;
+  };
+
+  std::array<Entry, CAPACITY> entries_;
+  size_t top_ = 0;
+
+  void update(chess::board::Color perspective,
+              const chess::board::BoardState &boardState,
+              const Network &network);
+  void refresh(chess::board::Color perspective,
+               const chess::board::BoardState &boardState,
+               const Network &network);
+
+public:
+  // Starts a new path at `root`.
+  void reset(const chess::board::BoardState &root);
+  // Records a move (or a pass) from `parent` to `child`, the two positions
+  // on either side of doMove. Throws std::logic_error on a path longer
+  // than the stack.
+  void push(const chess::board::BoardState &parent,
+            const chess::board::BoardState &child);
+  // Undoes the last push, for copy-make's restore of the parent.
+  void pop() { --top_; }
+
+  // `boardState` must be the position of the last push.
+  [[nodiscard]] int evaluate(const chess::board::BoardState &boardState,
+                             const Network &network);
+
+  // The first layer outputs of `perspective` at the last push, brought up
+  // to date as evaluate would, for checking against a fresh stack.
+  [[nodiscard]] const std::array<int16_t, HIDDEN_SIZE> &
+  getValues(chess::board::Color perspective,
+            const chess::board::BoardState &boardState,
+            const Network &network);
+};
+
+} // namespace chess::nnue
@@ -0,0 +1,294 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <optional>
+#include <string_view>
+#include <system_error>
+
+module chess.notation;
+
+import chess.core;
+import chess.cords;
+import chess.board_state;
+import chess.move;
+import chess.move_executor;
+import chess.move_generator;
+import chess.generator_helpers;
+
+namespace chess::notation {
+
+using chess::board::Bitboard;
+using chess::board::BoardState;
+using chess::board::Color;
+using chess::board::Cords;
+using chess::board::Move;
+using chess::board::MoveList;
+using chess::board::Name;
+
+namespace {
+
+constexpr std::string_view PIECE_LETTERS = "PNBRQK";
+constexpr std::string_view PROMOTION_LETTERS = "nbrq";
+
+std::optional<Name> getPieceNameAt(const BoardState &boardState,
+                                   const Color color, const Bitboard square) {
+  for (size_t i = 0; i < static_cast<size_t>(Name::COUNT); ++i) {
+    if (boardState.getPieces(color, static_cast<Name>(i)) & square)
+      return static_cast<Name>(i);
+  }
+  return std::nullopt;
+}
+
+bool isLegal(const BoardState &boardState, const Move &move) {
+  BoardState next = boardState;
+  chess::move_executor::doMove(next, move);
+  return !chess::move_generator::isInCheck(boardState.getTurnColor(), next);
+}
+
+bool hasLegalMove(const BoardState &boardState) {
+  MoveList moves;
+  chess::move_generator::getPossibleMoves(boardState, moves);
+  return std::any_of(moves.begin(), moves.end(), [&](const Move &move) {
+    return isLegal(boardState, move);
+  });
+}
+
+// Squares from which a `name` on `index` attacks, which for every piece but
+// pawns are also the squares it can come from.
+Bitboard getPieceAttacks(const Name name, const uint8_t index,
+                         const Bitboard empty) {
+  using namespace chess::move_generator;
+  switch (name) {
+  case Name::KNIGHT:
+    return getKnightAttacks(index);
+  case Name::BISHOP:
+    return getBishopAttacks(index, empty);
+  case Name::ROOK:
+    return getRookAttacks(index, empty);
+  case Name::QUEEN:
+    return getBishopAttacks(index, empty) | getRookAttacks(index, empty);
+  case Name::KING:
+    return getKingAttacks(index);
+  default:
+    return 0ULL;
+  }
+}
+
+char *writeSquare(char *out, const uint8_t index) {
+  *out++ = static_cast<char>('a' + index % 8);
+  *out++ = static_cast<char>('8' - index / 8);
+  return out;
+}
+
+std::optional<uint8_t> parseSquare(const char file, const char rank) {
+  if (file < 'a' || file > 'h' || rank < '1' || rank > '8')
+    return std::nullopt;
+  return static_cast<uint8_t>((('8' - rank) * 8) + (file - 'a'));
+}
+
+std::to_chars_result copyOut(char *first, char *last, const char *buffer,
+                             const char *bufferEnd) {
+  if (last - first < bufferEnd - buffer)
+    return {last, std::errc::value_too_large};
+  return {std::copy(buffer, bufferEnd, first), std::errc{}};
+}
+
+bool isCastling(const Move &move, const Name name) {
+  return name == Name::KING &&
+         std::abs(move.getEndSquare().x_ - move.getStartSquare().x_) == 2;
+}
+
+} // namespace
+
+#pragma region encoding
+auto toUci(char *first, char *last, const Move &move)
+    -> std::to_chars_result {
+  std::array<char, MAX_UCI_LENGTH> buffer;
+  char *out = buffer.data();
+
+  if (move == Move{}) {
+    out = std::copy_n("0000", 4, out);
+  } else {
+    out = writeSquare(out, move.getStartSquare().getIndex());
+    out = writeSquare(out, move.getEndSquare().getIndex());
+    if (auto promotion = move.tryGetPromotionName())
+      *out++ = PROMOTION_LETTERS[static_cast<size_t>(*promotion) - 1];
+  }
+  return copyOut(first, last, buffer.data(), out);
+}
+
+auto toSan(char *first, char *last, const BoardState &boardState,
+           const Move &move) -> std::to_chars_result {
+  const Color color = boardState.getTurnColor();
+  const uint8_t from = move.getStartSquare().getIndex(),
+                to = move.getEndSquare().getIndex();
+  const std::optional<Name> name =
+      getPieceNameAt(boardState, color, move.getStartBoard());
+  if (!name)
+    return {first, std::errc::invalid_argument};
+
+  std::array<char, MAX_SAN_LENGTH> buffer;
+  char *out = buffer.data();
+
+  if (isCastling(move, *name)) {
+    out = to % 8 > from % 8 ? std::copy_n("O-O", 3, out)
+                            : std::copy_n("O-O-O", 5, out);
+  } else {
+    const bool isCapture = chess::move_generator::isCapture(boardState, move);
+    if (*name == Name::PAWN) {
+      if (isCapture)
+        *out++ = static_cast<char>('a' + from % 8);
+    } else {
+      *out++ = PIECE_LETTERS[static_cast<size_t>(*name)];
+
+      // Other pieces of the same kind that could legally go there too.
+      Bitboard rivals = getPieceAttacks(*name, to, boardState.getEmpty()) &
+                        boardState.getPieces(color, *name) &
+                        ~move.getStartBoard();
+      bool isAmbiguous = false, sharesFile = false, sharesRank = false;
+      while (auto rival = chess::board::getNextPiece(rivals)) {
+        if (!isLegal(boardState, Move(Cords(rival->index), Cords(to))))
+          continue;
+        isAmbiguous = true;
+        sharesFile |= rival->index % 8 == from % 8;
+        sharesRank |= rival->index / 8 == from / 8;
+      }
+      if (isAmbiguous && (!sharesFile || sharesRank))
+        *out++ = static_cast<char>('a' + from % 8);
+      if (isAmbiguous && sharesFile)
+        *out++ = static_cast<char>('8' - from / 8);
+    }
+    if (isCapture)
+      *out++ = 'x';
+    out = writeSquare(out, to);
+    if (auto promotion = move.tryGetPromotionName()) {
+      *out++ = '=';
+      *out++ = PIECE_LETTERS[static_cast<size_t>(*promotion)];
+    }
+  }
+
+  BoardState next = boardState;
+  chess::move_executor::doMove(next, move);
+  if (chess::move_generator::isInCheck(getOppositeColor(color), next))
+    *out++ = hasLegalMove(next) ? '+' : '#';
+
+  return copyOut(first, last, buffer.data(), out);
+}
+#pragma endregion
+
+#pragma region decoding
+auto parseUci(const BoardState &boardState, const std::string_view text)
+    -> std::optional<Move> {
+  if (text.size() != 4 && text.size() != 5)
+    return std::nullopt;
+  const auto from = parseSquare(text[0], text[1]),
+             to = parseSquare(text[2], text[3]);
+  if (!from || !to)
+    return std::nullopt;
+
+  MoveList moves;
+  chess::move_generator::getPossibleMoves(boardState, moves);
+  for (const Move &move : moves) {
+    if (move.getStartSquare().getIndex() != *from ||
+        move.getEndSquare().getIndex() != *to)
+      continue;
+    const std::optional<Name> promotion = move.tryGetPromotionName();
+    const bool promotionMatches =
+        text.size() == 4
+            ? !promotion
+            : promotion && PROMOTION_LETTERS[static_cast<size_t>(*promotion) -
+                                             1] == text[4];
+    if (promotionMatches && isLegal(boardState, move))
+      return move;
+  }
+  return std::nullopt;
+}
+
+auto parseSan(const BoardState &boardState, std::string_view text)
+    -> std::optional<Move> {
+  while (!text.empty() && std::string_view("+#!?").find(text.back()) !=
+                              std::string_view::npos)
+    text.remove_suffix(1);
+
+  const Color color = boardState.getTurnColor();
+  MoveList moves;
+  chess::move_generator::getPossibleMoves(boardState, moves);
+
+  if (text == "O-O" || text == "0-0" || text == "O-O-O" || text == "0-0-0") {
+    const bool isKingside = text.size() == 3;
+    for (const Move &move : moves) {
+      if (isCastling(move, getPieceNameAt(boardState, color,
+                                          move.getStartBoard())
+                               .value_or(Name::PAWN)) &&
+          (move.getEndSquare().x_ > move.getStartSquare().x_) == isKingside &&
+          isLegal(boardState, move))
+        return move;
+    }
+    return std::nullopt;
+  }
+
+  Name name = Name::PAWN;
+  if (!text.empty() && text.front() != 'P') {
+    const size_t letter = PIECE_LETTERS.find(text.front());
+    if (letter != std::string_view::npos) {
+      name = static_cast<Name>(letter);
+      text.remove_prefix(1);
+    }
+  } else if (!text.empty()) {
+    text.remove_prefix(1); // an explicit pawn letter
+  }
+
+  std::optional<Name> promotion;
+  if (!text.empty() && std::string_view("NBRQ").find(text.back()) !=
+                           std::string_view::npos) {
+    promotion = static_cast<Name>(PIECE_LETTERS.find(text.back()));
+    text.remove_suffix(1);
+    if (!text.empty() && text.back() == '=')
+      text.remove_suffix(1);
+  }
+
+  if (text.size() < 2)
+    return std::nullopt;
+  const auto to = parseSquare(text[text.size() - 2], text.back());
+  if (!to)
+    return std::nullopt;
+  text.remove_suffix(2);
+  if (!text.empty() && (text.back() == 'x' || text.back() == ':'))
+    text.remove_suffix(1);
+
+  // Whatever is left narrows down the start square.
+  std::optional<int> fromFile, fromRank;
+  for (const char c : text) {
+    if (c >= 'a' && c <= 'h')
+      fromFile = c - 'a';
+    else if (c >= '1' && c <= '8')
+      fromRank = '8' - c;
+    else
+      return std::nullopt;
+  }
+
+  std::optional<Move> found;
+  for (const Move &move : moves) {
+    const Cords start = move.getStartSquare();
+    if (move.getEndSquare().getIndex() != *to ||
+        (fromFile && start.x_ != *fromFile) ||
+        (fromRank && start.y_ != *fromRank) ||
+        move.tryGetPromotionName() != promotion ||
+        getPieceNameAt(boardState, color, move.getStartBoard()) != name ||
+        !isLegal(boardState, move))
+      continue;
+    if (found)
+      return std::nullopt; // ambiguous
+    found = move;
+  }
+  return found;
+}
+#pragma endregion
+
+} // namespace chess::notation
@@ -0,0 +1,41 @@
+module;
+
+#include <charconv>
+#include <cstddef>
+#include <optional>
+#include <string_view>
+
+export module chess.notation;
+
+import chess.board_state;
+import chess.move;
+
+export namespace chess::notation {
+
+export inline constexpr size_t MAX_UCI_LENGTH = 5; // e7e8q
+export inline constexpr size_t MAX_SAN_LENGTH = 7; // Qa1xb2+, exd8=Q#
+
+// Encoders work like std::to_chars: they write into [first, last) without a
+// terminator and return the end of the output, or value_too_large with
+// `last` when the buffer is too small. Nothing is allocated.
+
+// Long algebraic notation; "0000" for the null move.
+export auto toUci(char *first, char *last, const chess::board::Move &move)
+    -> std::to_chars_result;
+// Standard algebraic notation of `move` played in `boardState`, with the
+// minimal disambiguation and a check or mate suffix.
+export auto toSan(char *first, char *last,
+                  const chess::board::BoardState &boardState,
+                  const chess::board::Move &move) -> std::to_chars_result;
+
+// Decoders return the legal move of `boardState` that `text` names, if any.
+export auto parseUci(const chess::board::BoardState &boardState,
+                     std::string_view text)
+    -> std::optional<chess::board::Move>;
+// Accepts the usual variations: castling with zeros, a missing '=' before
+// the promotion piece, and trailing check, mate and annotation marks.
+export auto parseSan(const chess::board::BoardState &boardState,
+                     std::string_view text)
+    -> std::optional<chess::board::Move>;
+
+} // namespace chess::notation
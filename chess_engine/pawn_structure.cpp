@@ -0,0 +1,104 @@
+module;
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+module chess.pawn_structure;
+
+import chess.core;
+import chess.score;
+import chess.shifts;
+import chess.board_state;
+import chess.generator_helpers;
+
+namespace chess::evaluation {
+
+using chess::board::Bitboard;
+using chess::board::BoardState;
+using chess::board::Color;
+using chess::board::Name;
+using chess::board::Score;
+
+namespace {
+
+Score evaluateSide(const Color us, const Bitboard ourPawns,
+                   const Bitboard theirPawns, Bitboard &passedPawns) {
+  const PawnClasses classes = classifyPawns(us, ourPawns, theirPawns);
+  passedPawns = classes.passed;
+
+  Score score = DOUBLED_PAWN * std::popcount(classes.doubled) +
+                ISOLATED_PAWN * std::popcount(classes.isolated) +
+                BACKWARD_PAWN * std::popcount(classes.backward);
+  Bitboard passed = classes.passed;
+  while (auto pawn = chess::board::getNextPiece(passed)) {
+    const size_t rank =
+        us == Color::WHITE ? 7 - pawn->index / 8 : pawn->index / 8;
+    score += PASSED_PAWN[rank];
+  }
+  return score;
+}
+
+} // namespace
+
+auto classifyPawns(const Color us, const Bitboard ourPawns,
+                   const Bitboard theirPawns) -> PawnClasses {
+  const Color them = getOppositeColor(us);
+  const Bitboard theirAttacks =
+      chess::move_generator::getPawnAttacks(them, theirPawns);
+  const Bitboard ourAttackSpan = getAdjacentFiles(getFrontSpan(us, ourPawns));
+  const Bitboard theirFrontSpan = getFrontSpan(them, theirPawns);
+
+  PawnClasses classes;
+  // Another of ours somewhere in front of it.
+  classes.doubled = ourPawns & getFrontSpan(them, ourPawns);
+  classes.isolated =
+      ourPawns & ~getAdjacentFiles(fillNorth(ourPawns) | fillSouth(ourPawns));
+  // Its advance is contested and no neighbour can come to its support.
+  const Bitboard weakStops = theirAttacks & ~ourAttackSpan;
+  classes.backward = ourPawns & ~classes.isolated &
+                     (us == Color::WHITE ? chess::board::shiftSouth(weakStops)
+                                         : chess::board::shiftNorth(weakStops));
+  // No enemy pawn in front of it or on either side of that.
+  classes.passed = ourPawns & ~classes.doubled &
+                   ~(theirFrontSpan | getAdjacentFiles(theirFrontSpan));
+  return classes;
+}
+
+auto evaluatePawns(const BoardState &boardState) -> PawnEntry {
+  PawnEntry entry;
+  entry.key = boardState.getPawnHash();
+
+  const Bitboard whitePawns = boardState.getPieces(Color::WHITE, Name::PAWN),
+                 blackPawns = boardState.getPieces(Color::BLACK, Name::PAWN);
+  entry.attackSpans[static_cast<size_t>(Color::WHITE)] =
+      getAdjacentFiles(getFrontSpan(Color::WHITE, whitePawns));
+  entry.attackSpans[static_cast<size_t>(Color::BLACK)] =
+      getAdjacentFiles(getFrontSpan(Color::BLACK, blackPawns));
+
+  entry.score =
+      evaluateSide(Color::WHITE, whitePawns, blackPawns,
+                   entry.passedPawns[static_cast<size_t>(Color::WHITE)]) -
+      evaluateSide(Color::BLACK, blackPawns, whitePawns,
+                   entry.passedPawns[static_cast<size_t>(Color::BLACK)]);
+  return entry;
+}
+
+const PawnEntry &PawnTable::probe(const BoardState &boardState) {
+  const uint64_t key = boardState.getPawnHash();
+  PawnEntry &entry = entries_[key & (SIZE - 1)];
+  ++probes_;
+  if (entry.key == key)
+    ++hits_;
+  else
+    entry = evaluatePawns(boardState);
+  return entry;
+}
+
+void PawnTable::clear() {
+  entries_.fill({});
+  probes_ = hits_ = 0;
+}
+
+} // namespace chess::evaluation
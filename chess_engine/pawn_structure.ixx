@@ -0,0 +1,98 @@
+module;
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+export module chess.pawn_structure;
+
+import chess.core;
+import chess.score;
+import chess.eval_parameters;
+import chess.shifts;
+import chess.board_state;
+
+export namespace chess::evaluation {
+
+export inline constexpr chess::board::Score
+    DOUBLED_PAWN = chess::board::makeScore(parameters::DOUBLED_PAWN),
+    ISOLATED_PAWN = chess::board::makeScore(parameters::ISOLATED_PAWN),
+    BACKWARD_PAWN = chess::board::makeScore(parameters::BACKWARD_PAWN);
+// By rank counted from the pawn's own side.
+export inline constexpr std::array<chess::board::Score, 8> PASSED_PAWN = [] {
+  std::array<chess::board::Score, 8> scores{};
+  for (size_t rank = 0; rank < scores.size(); ++rank)
+    scores[rank] = chess::board::makeScore(parameters::PASSED_PAWN[rank]);
+  return scores;
+}();
+
+// Rank 8 is at the low end of the bitboard, so north is a right shift.
+export constexpr chess::board::Bitboard fillNorth(chess::board::Bitboard b) {
+  b |= b >> 8;
+  b |= b >> 16;
+  return b | b >> 32;
+}
+
+export constexpr chess::board::Bitboard fillSouth(chess::board::Bitboard b) {
+  b |= b << 8;
+  b |= b << 16;
+  return b | b << 32;
+}
+
+// Squares in front of `pawns`, from `color`'s point of view.
+export constexpr chess::board::Bitboard
+getFrontSpan(const chess::board::Color color,
+             const chess::board::Bitboard pawns) {
+  return color == chess::board::Color::WHITE
+             ? fillNorth(chess::board::shiftNorth(pawns))
+             : fillSouth(chess::board::shiftSouth(pawns));
+}
+
+export constexpr chess::board::Bitboard
+getAdjacentFiles(const chess::board::Bitboard squares) {
+  return chess::board::shiftWest(squares) | chess::board::shiftEast(squares);
+}
+
+// One side's pawns sorted by the terms that apply to them.
+export struct PawnClasses {
+  chess::board::Bitboard doubled, isolated, backward, passed;
+};
+
+// Works on all of `us`'s pawns at once, so it costs the same however many
+// there are.
+export auto classifyPawns(chess::board::Color us,
+                          chess::board::Bitboard ourPawns,
+                          chess::board::Bitboard theirPawns) -> PawnClasses;
+
+// Everything the evaluation derives from the pawns alone.
+export struct PawnEntry {
+  uint64_t key = 0;
+  chess::board::Score score = 0; // white's advantage
+  std::array<chess::board::Bitboard, 2> passedPawns{};
+  // Squares each side's pawns attack or could attack by advancing.
+  std::array<chess::board::Bitboard, 2> attackSpans{};
+};
+
+// Doubled, isolated, backward and passed pawns, computed from scratch.
+export auto evaluatePawns(const chess::board::BoardState &boardState)
+    -> PawnEntry;
+
+// Fixed size cache of evaluatePawns keyed by the pawn hash, one per search
+// thread so it needs no synchronization. Pawn structures repeat across most
+// of a tree, so nearly every probe hits. A position without pawns has key
+// 0, for which the zeroed empty slots already hold the right answer.
+export class PawnTable {
+private:
+  static constexpr size_t SIZE = 1 << 13;
+  std::array<PawnEntry, SIZE> entries_{};
+  uint64_t probes_ = 0, hits_ = 0;
+
+public:
+  const PawnEntry &probe(const chess::board::BoardState &boardState);
+  void clear();
+
+  [[nodiscard]] uint64_t getProbes() const { return probes_; }
+  [[nodiscard]] uint64_t getHits() const { return hits_; }
+};
+
+} // namespace chess::evaluation
@@ -0,0 +1,143 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <optional>
+#include <ostream>
+
+#ifdef __linux__
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+module chess.perf_counters;
+
+namespace chess::perf {
+
+namespace {
+
+#ifdef __linux__
+struct EventConfig {
+  uint32_t type;
+  uint64_t config;
+};
+
+constexpr std::array<EventConfig, static_cast<size_t>(Counter::COUNT)>
+    EVENTS = {{
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+        {PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_L1D |
+                                 (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                 (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES},
+        {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+    }};
+
+int openEvent(const EventConfig &event) {
+  perf_event_attr attributes;
+  std::memset(&attributes, 0, sizeof(attributes));
+  attributes.size = sizeof(attributes);
+  attributes.type = event.type;
+  attributes.config = event.config;
+  attributes.disabled = 1;
+  attributes.exclude_kernel = 1;
+  attributes.exclude_hv = 1;
+  // The kernel may multiplex more events than there are counters; these let
+  // the count be scaled back up.
+  attributes.read_format =
+      PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+  return static_cast<int>(
+      syscall(SYS_perf_event_open, &attributes, 0, -1, -1, 0));
+}
+
+std::optional<uint64_t> readEvent(const int descriptor) {
+  uint64_t values[3]; // count, time enabled, time running
+  if (read(descriptor, values, sizeof(values)) != sizeof(values) ||
+      values[2] == 0)
+    return std::nullopt;
+  if (values[2] == values[1])
+    return values[0];
+  return static_cast<uint64_t>(static_cast<double>(values[0]) * values[1] /
+                               values[2]);
+}
+#endif
+
+} // namespace
+
+PerfCounters::PerfCounters() {
+  descriptors_.fill(-1);
+#ifdef __linux__
+  for (size_t i = 0; i < EVENTS.size(); ++i)
+    descriptors_[i] = openEvent(EVENTS[i]);
+#endif
+}
+
+PerfCounters::~PerfCounters() {
+#ifdef __linux__
+  for (const int descriptor : descriptors_) {
+    if (descriptor >= 0)
+      close(descriptor);
+  }
+#endif
+}
+
+bool PerfCounters::isAvailable() const {
+  return std::any_of(descriptors_.begin(), descriptors_.end(),
+                     [](const int descriptor) { return descriptor >= 0; });
+}
+
+void PerfCounters::start() {
+#ifdef __linux__
+  for (const int descriptor : descriptors_) {
+    if (descriptor < 0)
+      continue;
+    ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+    ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+  }
+#endif
+}
+
+void PerfCounters::stop() {
+#ifdef __linux__
+  for (size_t i = 0; i < descriptors_.size(); ++i) {
+    if (descriptors_[i] < 0)
+      continue;
+    ioctl(descriptors_[i], PERF_EVENT_IOC_DISABLE, 0);
+    if (auto count = readEvent(descriptors_[i]))
+      totals_[i] = totals_[i].value_or(0) + *count;
+  }
+#endif
+}
+
+void printCounters(std::ostream &out, const PerfCounters &counters,
+                   const uint64_t nodes) {
+  if (!counters.isAvailable()) {
+    out << "Hardware counters unavailable" << std::endl;
+    return;
+  }
+
+  const CounterValues &totals = counters.getTotals();
+  out << '\n';
+  for (size_t i = 0; i < totals.size(); ++i) {
+    out << COUNTER_NAMES[i] << "/node : ";
+    if (totals[i] && nodes > 0)
+      out << std::fixed << std::setprecision(2)
+          << static_cast<double>(*totals[i]) / nodes << '\n';
+    else
+      out << "n/a\n";
+  }
+  const auto &cycles = totals[static_cast<size_t>(Counter::CYCLES)],
+             &instructions = totals[static_cast<size_t>(Counter::INSTRUCTIONS)];
+  if (cycles && instructions && *cycles > 0)
+    out << "Instructions/cycle : " << std::fixed << std::setprecision(2)
+        << static_cast<double>(*instructions) / *cycles << '\n';
+  out << std::defaultfloat << std::flush;
+}
+
+} // namespace chess::perf
@@ -0,0 +1,62 @@
+module;
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string_view>
+
+export module chess.perf_counters;
+
+export namespace chess::perf {
+
+export enum class Counter {
+  CYCLES,
+  INSTRUCTIONS,
+  L1D_MISSES,
+  LLC_MISSES,
+  BRANCH_MISSES,
+  COUNT
+};
+
+export inline constexpr std::array<std::string_view,
+                                   static_cast<size_t>(Counter::COUNT)>
+    COUNTER_NAMES = {"Cycles", "Instructions", "L1d misses", "LLC misses",
+                     "Branch misses"};
+
+// Totals over every measured region; empty for counters that could not be
+// opened.
+export using CounterValues =
+    std::array<std::optional<uint64_t>, static_cast<size_t>(Counter::COUNT)>;
+
+// Hardware counters of the calling thread, read through perf_event_open.
+// Each counter is opened on its own, so a CPU or kernel that lacks one still
+// reports the others. Off Linux, or where perf events are not permitted,
+// nothing opens and the counters are simply unavailable.
+export class PerfCounters {
+private:
+  std::array<int, static_cast<size_t>(Counter::COUNT)> descriptors_;
+  CounterValues totals_{};
+
+public:
+  PerfCounters();
+  ~PerfCounters();
+  PerfCounters(const PerfCounters &) = delete;
+  PerfCounters &operator=(const PerfCounters &) = delete;
+
+  [[nodiscard]] bool isAvailable() const;
+
+  // Bracket a measured region; regions add up.
+  void start();
+  void stop();
+
+  [[nodiscard]] const CounterValues &getTotals() const { return totals_; }
+};
+
+// Writes each total divided by `nodes`, and instructions per cycle, or a note
+// that the counters are unavailable.
+export void printCounters(std::ostream &out, const PerfCounters &counters,
+                          uint64_t nodes);
+
+} // namespace chess::perf
@@ -0,0 +1,77 @@
+module;
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <stdexcept>
+
+module chess.perft;
+
+import chess.board_state;
+import chess.move;
+import chess.fen;
+import chess.move_executor;
+import chess.move_generator;
+import chess.perf_counters;
+
+namespace chess::perft {
+
+auto perft(const chess::board::BoardState &boardState, const int depth)
+    -> uint64_t {
+  if (depth <= 0)
+    return 1;
+  chess::board::MoveList legalMoves;
+  chess::move_generator::getLegalMoves(boardState, legalMoves);
+  // The last ply only needs counting.
+  if (depth == 1)
+    return legalMoves.size();
+
+  uint64_t nodes = 0;
+  for (const chess::board::Move &move : legalMoves) {
+    chess::board::BoardState next = boardState;
+    chess::move_executor::doMove(next, move);
+    nodes += perft(next, depth - 1);
+  }
+  return nodes;
+}
+
+auto runPerftSuite(std::ostream &out, const bool hardwareCounters) -> bool {
+  std::optional<chess::perf::PerfCounters> counters;
+  if (hardwareCounters)
+    counters.emplace();
+
+  bool passed = true;
+  uint64_t totalNodes = 0;
+  for (size_t i = 0; i < PERFT_SUITE.size(); ++i) {
+    const PerftCase &test = PERFT_SUITE[i];
+    const std::optional<chess::board::BoardState> position =
+        chess::board::parseFen(test.fen);
+    if (!position)
+      throw std::logic_error("Invalid perft position");
+
+    if (counters)
+      counters->start();
+    const auto start = std::chrono::steady_clock::now();
+    const uint64_t nodes = perft(*position, test.depth);
+    const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now() - start);
+    if (counters)
+      counters->stop();
+    totalNodes += nodes;
+    out << "Position " << i + 1 << "/" << PERFT_SUITE.size() << ", depth "
+        << test.depth << ": " << nodes << " nodes in " << elapsed.count()
+        << " ms";
+    if (nodes != test.nodes) {
+      out << ", expected " << test.nodes;
+      passed = false;
+    }
+    out << std::endl;
+  }
+  if (counters)
+    chess::perf::printCounters(out, *counters, totalNodes);
+  out << (passed ? "Perft passed" : "Perft FAILED") << std::endl;
+  return passed;
+}
+
+} // namespace chess::perft
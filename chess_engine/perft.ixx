@@ -0,0 +1,49 @@
+module;
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+export module chess.perft;
+
+import chess.board_state;
+
+export namespace chess::perft {
+
+export struct PerftCase {
+  std::string_view fen;
+  int depth;
+  uint64_t nodes;
+};
+
+// The usual move generator test positions with their published leaf
+// counts. Between them they cover castling through and out of check,
+// en passant, promotions and discovered checks.
+export inline constexpr std::array<PerftCase, 7> PERFT_SUITE = {{
+    {"rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4'865'609},
+    {"r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1",
+     4, 4'085'603},
+    {"8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6, 11'030'083},
+    {"r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 4,
+     422'333},
+    {"r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1", 4,
+     422'333},
+    {"rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4,
+     2'103'487},
+    {"r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10",
+     4, 3'894'594},
+}};
+
+// Leaves of the legal move tree `depth` plies below `boardState`.
+export auto perft(const chess::board::BoardState &boardState, int depth)
+    -> uint64_t;
+
+// Counts every suite position to its depth, one line each, and returns
+// false if any count differs from the published one. With
+// `hardwareCounters`, also reports the counters per leaf node, as bench does
+// per searched node.
+export auto runPerftSuite(std::ostream &out, bool hardwareCounters = false)
+    -> bool;
+
+} // namespace chess::perft
@@ -0,0 +1,181 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <span>
+#include <utility>
+
+module chess.repetition;
+
+import chess.core;
+import chess.board_state;
+import chess.generator_helpers;
+import chess.zobrist;
+
+namespace chess::search {
+
+namespace {
+
+constexpr size_t CUCKOO_SIZE = 8192;
+
+constexpr size_t cuckooIndex1(const uint64_t key) {
+  return key & (CUCKOO_SIZE - 1);
+}
+
+constexpr size_t cuckooIndex2(const uint64_t key) {
+  return (key >> 16) & (CUCKOO_SIZE - 1);
+}
+
+// Hash change of every reversible move (a non-pawn piece moving between two
+// squares it attacks on an empty board, plus the side to move flip) and the
+// squares it moves between.
+struct CuckooTables {
+  std::array<uint64_t, CUCKOO_SIZE> keys{};
+  std::array<std::pair<uint8_t, uint8_t>, CUCKOO_SIZE> squares{};
+};
+
+CuckooTables buildCuckooTables() {
+  using chess::board::Color;
+  using chess::board::Name;
+
+  CuckooTables tables;
+  const chess::board::Bitboard emptyBoard = ~0ULL;
+
+  for (size_t colorIndex = 0; colorIndex < 2; ++colorIndex) {
+    const Color color = static_cast<Color>(colorIndex);
+    for (Name name : {Name::KNIGHT, Name::BISHOP, Name::ROOK, Name::QUEEN,
+                      Name::KING}) {
+      for (uint8_t from = 0; from < 64; ++from) {
+        chess::board::Bitboard targets = 0ULL;
+        if (name == Name::KNIGHT)
+          targets = chess::move_generator::getKnightAttacks(from);
+        if (name == Name::KING)
+          targets = chess::move_generator::getKingAttacks(from);
+        if (name == Name::BISHOP || name == Name::QUEEN)
+          targets |= chess::move_generator::getBishopAttacks(from, emptyBoard);
+        if (name == Name::ROOK || name == Name::QUEEN)
+          targets |= chess::move_generator::getRookAttacks(from, emptyBoard);
+
+        for (uint8_t to = from + 1; to < 64; ++to) {
+          if (!(targets & (1ULL << to)))
+            continue;
+
+          uint64_t key = chess::board::getPieceKey(color, name, from) ^
+                         chess::board::getPieceKey(color, name, to) ^
+                         chess::board::ZOBRIST_KEYS.blackToMove;
+          std::pair<uint8_t, uint8_t> squares{from, to};
+
+          // Cuckoo insertion: evict whatever occupies the slot and move it
+          // to its alternative slot until everything fits.
+          size_t index = cuckooIndex1(key);
+          while (true) {
+            std::swap(tables.keys[index], key);
+            std::swap(tables.squares[index], squares);
+            if (!key)
+              break;
+            index = index == cuckooIndex1(key) ? cuckooIndex2(key)
+                                               : cuckooIndex1(key);
+          }
+        }
+      }
+    }
+  }
+  return tables;
+}
+
+const CuckooTables &getCuckooTables() {
+  static const CuckooTables tables = buildCuckooTables();
+  return tables;
+}
+
+// Squares strictly between two squares on a shared line, empty otherwise.
+chess::board::Bitboard getBetween(const uint8_t from, const uint8_t to) {
+  const chess::board::Bitboard fromBoard = 1ULL << from,
+                               toBoard = 1ULL << to;
+
+  if (chess::move_generator::getBishopAttacks(from, ~0ULL) & toBoard)
+    return chess::move_generator::getBishopAttacks(from, ~toBoard) &
+           chess::move_generator::getBishopAttacks(to, ~fromBoard);
+  if (chess::move_generator::getRookAttacks(from, ~0ULL) & toBoard)
+    return chess::move_generator::getRookAttacks(from, ~toBoard) &
+           chess::move_generator::getRookAttacks(to, ~fromBoard);
+  return 0ULL;
+}
+
+} // namespace
+
+auto isRepetition(std::span<const uint64_t> history,
+                  const uint16_t halfmoveClock, const uint8_t ply) -> bool {
+  if (history.empty())
+    return false;
+
+  const size_t window = std::min<size_t>(halfmoveClock, history.size() - 1);
+  const uint64_t current = history.back();
+  int earlierOccurrences = 0;
+
+  // Same side to move, and at least two moves by each side in between.
+  for (size_t back = 4; back <= window; back += 2) {
+    if (history[history.size() - 1 - back] != current)
+      continue;
+    if (back < ply || ++earlierOccurrences == 2)
+      return true;
+  }
+  return false;
+}
+
+auto hasUpcomingRepetition(const chess::board::BoardState &boardState,
+                           std::span<const uint64_t> history,
+                           const uint8_t ply) -> bool {
+  if (history.empty())
+    return false;
+
+  const size_t window =
+      std::min<size_t>(boardState.getHalfmoveClock(), history.size() - 1);
+  const uint64_t current = history.back();
+  const chess::board::Bitboard occupied = ~boardState.getEmpty();
+  const CuckooTables &tables = getCuckooTables();
+
+  // Earlier positions with the opponent to move, one move away from ours.
+  for (size_t back = 3; back <= window && back < ply; back += 2) {
+    const uint64_t moveKey = current ^ history[history.size() - 1 - back];
+
+    size_t index = cuckooIndex1(moveKey);
+    if (tables.keys[index] != moveKey) {
+      index = cuckooIndex2(moveKey);
+      if (tables.keys[index] != moveKey)
+        continue;
+    }
+
+    // The move must be playable: nothing in the way, and the piece on
+    // exactly one of its two squares.
+    const auto [from, to] = tables.squares[index];
+    const chess::board::Bitboard endpoints = (1ULL << from) | (1ULL << to);
+    if (!(getBetween(from, to) & occupied) &&
+        std::popcount(endpoints & occupied) == 1)
+      return true;
+  }
+  return false;
+}
+
+auto isFiftyMoveDraw(const chess::board::BoardState &boardState) -> bool {
+  return boardState.getHalfmoveClock() >= 100;
+}
+
+auto hasInsufficientMaterial(const chess::board::BoardState &boardState)
+    -> bool {
+  using chess::board::Color;
+  using chess::board::Name;
+  chess::board::Bitboard heavy = 0, minor = 0;
+  for (const Color color : {Color::WHITE, Color::BLACK}) {
+    heavy |= boardState.getPieces(color, Name::PAWN) |
+             boardState.getPieces(color, Name::ROOK) |
+             boardState.getPieces(color, Name::QUEEN);
+    minor |= boardState.getPieces(color, Name::KNIGHT) |
+             boardState.getPieces(color, Name::BISHOP);
+  }
+  return !heavy && std::popcount(minor) <= 1;
+}
+
+} // namespace chess::search
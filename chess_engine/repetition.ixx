@@ -0,0 +1,38 @@
+module;
+
+#include <cstdint>
+#include <span>
+
+export module chess.repetition;
+
+import chess.board_state;
+
+export namespace chess::search {
+
+// `history` holds the hashes of every position of the game and the search so
+// far, ending with the current one; `ply` is the current distance from the
+// search root. Only the reversible-move window given by the halfmove clock is
+// scanned, since no position before a capture or pawn move can recur.
+
+// True for a position seen twice before, or once before inside the search
+// tree, where a single repetition is treated as the draw it can be forced
+// into.
+export auto isRepetition(std::span<const uint64_t> history,
+                         const uint16_t halfmoveClock, const uint8_t ply)
+    -> bool;
+
+// True if the side to move has a reversible move back into a position seen
+// inside the search tree, so the node is worth at least a draw. Found by
+// looking the hash difference to earlier positions up in a cuckoo table of
+// every single piece move.
+export auto hasUpcomingRepetition(const chess::board::BoardState &boardState,
+                                  std::span<const uint64_t> history,
+                                  const uint8_t ply) -> bool;
+
+export auto isFiftyMoveDraw(const chess::board::BoardState &boardState) -> bool;
+
+// Neither side can ever mate: bare kings, or a single minor piece.
+export auto hasInsufficientMaterial(const chess::board::BoardState &boardState)
+    -> bool;
+
+} // namespace chess::search
@@ -0,0 +1,84 @@
+module;
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+export module chess.score;
+
+import chess.core;
+import chess.eval_parameters;
+
+export namespace chess::board {
+
+// A middlegame and an endgame value packed into one integer, so both are
+// added and subtracted with a single instruction. The endgame half sits in
+// the upper 16 bits; the lower half borrows from it when negative, which
+// getEndgame undoes.
+export using Score = int32_t;
+
+export constexpr Score makeScore(const int middlegame, const int endgame) {
+  return static_cast<Score>(static_cast<uint32_t>(endgame) << 16) + middlegame;
+}
+
+export constexpr Score
+makeScore(const chess::evaluation::parameters::Weight weight) {
+  return makeScore(weight.middlegame, weight.endgame);
+}
+
+export constexpr int getMiddlegame(const Score score) {
+  return static_cast<int16_t>(static_cast<uint16_t>(score));
+}
+
+export constexpr int getEndgame(const Score score) {
+  return static_cast<int16_t>(
+      static_cast<uint16_t>((static_cast<uint32_t>(score) + 0x8000) >> 16));
+}
+
+// Game phase: the sum of these weights over the pieces on the board, from
+// MAX_PHASE with every piece down to 0 with only kings and pawns.
+export inline constexpr std::array<int, static_cast<size_t>(Name::COUNT)>
+    PHASE_WEIGHTS = {0, 1, 1, 2, 4, 0};
+export inline constexpr int MAX_PHASE = 24;
+
+// Blends the two halves of `score` by the game phase.
+export constexpr int taper(const Score score, const int phase) {
+  return (getMiddlegame(score) * phase +
+          getEndgame(score) * (MAX_PHASE - phase)) /
+         MAX_PHASE;
+}
+
+// Material plus square bonus of every piece on every square, positive for
+// white and negative for black, so a position's sum is white's advantage.
+export using PieceSquareScores =
+    std::array<std::array<std::array<Score, 64>,
+                          static_cast<size_t>(Name::COUNT)>,
+               static_cast<size_t>(Color::COUNT)>;
+
+constexpr PieceSquareScores generatePieceSquareScores() {
+  namespace parameters = chess::evaluation::parameters;
+  PieceSquareScores scores{};
+  for (size_t name = 0; name < static_cast<size_t>(Name::COUNT); ++name) {
+    for (size_t square = 0; square < 64; ++square) {
+      const Score white =
+          makeScore(parameters::MIDDLEGAME_VALUES[name] +
+                        parameters::MIDDLEGAME_SQUARES[name][square],
+                    parameters::ENDGAME_VALUES[name] +
+                        parameters::ENDGAME_SQUARES[name][square]);
+      scores[static_cast<size_t>(Color::WHITE)][name][square] = white;
+      scores[static_cast<size_t>(Color::BLACK)][name][square ^ 56] = -white;
+    }
+  }
+  return scores;
+}
+
+export inline constexpr PieceSquareScores PIECE_SQUARE_SCORES =
+    generatePieceSquareScores();
+
+export constexpr Score getPieceSquareScore(const Color color, const Name name,
+                                           const size_t square) {
+  return PIECE_SQUARE_SCORES[static_cast<size_t>(color)]
+                            [static_cast<size_t>(name)][square];
+}
+
+} // namespace chess::board
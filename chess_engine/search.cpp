@@ -0,0 +1,879 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <stop_token>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+module chess.search;
+
+import chess.alloc_tracking;
+import chess.attack_map;
+import chess.core;
+import chess.eval_cache;
+import chess.evaluation;
+import chess.board_state;
+import chess.move;
+import chess.move_executor;
+import chess.move_generator;
+import chess.generator_helpers;
+import chess.nnue;
+import chess.repetition;
+import chess.search_stats;
+import chess.trace;
+import chess.transposition_table;
+
+namespace chess::search {
+
+using chess::board::Bitboard;
+using chess::board::BoardState;
+using chess::board::Color;
+using chess::board::Move;
+using chess::board::MoveList;
+using chess::board::Name;
+using chess::move_generator::AttackMap;
+using chess::nnue::Network;
+
+namespace {
+
+// The end of the game history that can still matter to the search. Only
+// positions since the last capture or pawn move can recur, and a line that
+// makes the halfmove clock reach a hundred is a draw before any repetition
+// is looked for.
+std::span<const uint64_t>
+getRepetitionWindow(std::span<const uint64_t> gameHistory,
+                    const BoardState &rootState) {
+  const bool endsWithRoot =
+      !gameHistory.empty() && gameHistory.back() == rootState.getHash();
+  const size_t length =
+      std::min<size_t>(rootState.getHalfmoveClock(), REPETITION_WINDOW - 1) +
+      (endsWithRoot ? 1 : 0);
+  return gameHistory.last(std::min(length, gameHistory.size()));
+}
+
+// Mate scores are stored relative to the node instead of the root so they
+// stay correct when the entry is reached through a different path length.
+constexpr int scoreToTable(const int score, const uint8_t ply) {
+  if (score >= CHECKMATE_SCORE - MAX_PLY)
+    return score + ply;
+  if (score <= -CHECKMATE_SCORE + MAX_PLY)
+    return score - ply;
+  return score;
+}
+
+constexpr int scoreFromTable(const int score, const uint8_t ply) {
+  if (score >= CHECKMATE_SCORE - MAX_PLY)
+    return score - ply;
+  if (score <= -CHECKMATE_SCORE + MAX_PLY)
+    return score + ply;
+  return score;
+}
+
+} // namespace
+
+#pragma region search_thread
+SearchThread::SearchThread(const size_t index,
+                           TranspositionTable &transpositionTable,
+                           chess::evaluation::EvalCache &evalCache,
+                           const std::atomic<bool> &stop,
+                           const SelectivityParams &selectivityParams,
+                           const std::shared_ptr<const Network> &network)
+    : index_(index), transpositionTable_(transpositionTable),
+      evalCache_(evalCache), stop_(stop),
+      selectivityParams_(selectivityParams), network_(network) {
+  // Reserved up front so the thread's memory does not grow with the game.
+  hashHistory_.reserve(REPETITION_WINDOW + MAX_PLY);
+  principalVariation_.reserve(MAX_PLY);
+}
+
+void SearchThread::search(
+    const BoardState &rootState, std::span<const uint64_t> gameHistory,
+    const SearchLimits &limits,
+    const std::function<void(const IterationInfo &)> &onIteration) {
+  static constexpr int ASPIRATION_WINDOW = 50;
+
+  const auto startTime = std::chrono::steady_clock::now();
+  const chess::alloc::AllocationCounts allocationsAtStart =
+      chess::alloc::getThreadAllocations();
+  const uint64_t pawnProbesAtStart = pawnTable_.getProbes(),
+                 pawnHitsAtStart = pawnTable_.getHits();
+
+  boardState_ = rootState;
+  accumulators_.reset(rootState);
+  hashHistory_.assign(gameHistory.begin(), gameHistory.end());
+  if (hashHistory_.empty() || hashHistory_.back() != rootState.getHash())
+    hashHistory_.push_back(rootState.getHash());
+  nodes_.store(0, std::memory_order_relaxed);
+  nodeLimit_ = limits.nodes;
+  deadline_.reset();
+  if (limits.moveTime.count() > 0)
+    deadline_ = startTime + limits.moveTime;
+  limitReached_ = false;
+  stats_ = {};
+  result_ = {};
+  principalVariation_.clear();
+  killers_ = {};
+  for (auto &colorHistory : history_)
+    for (auto &fromHistory : colorHistory)
+      for (int &entry : fromHistory)
+        entry /= 2; // age rather than forget the previous move's history
+
+  int previousScore = 0;
+
+  // Iterative deepening: each iteration seeds move ordering (through the
+  // principal variation) and the aspiration window of the next one.
+  for (int currentDepth = 1 + static_cast<int>(index_ % 2);
+       currentDepth <= limits.depth; ++currentDepth) {
+    chess::trace::Scope iterationTrace("iteration", "depth", currentDepth);
+    int delta = ASPIRATION_WINDOW;
+    int alpha = -INFINITE_SCORE, beta = INFINITE_SCORE;
+    if (result_.completedDepth > 0) {
+      alpha = std::max(previousScore - delta, -INFINITE_SCORE);
+      beta = std::min(previousScore + delta, INFINITE_SCORE);
+    }
+
+    MinimaxResult result;
+    {
+      // The tree itself must not touch the heap; the reporting below may.
+      chess::alloc::AllocationFreeRegion allocationFree;
+      while (true) {
+        chess::trace::Scope windowTrace("aspiration window", "width",
+                                        beta - alpha);
+        result = minimax({.depth = currentDepth,
+                          .alpha = alpha,
+                          .beta = beta,
+                          .ply = 0,
+                          .followsPv = true});
+        if (isStopped())
+          return; // the interrupted iteration is not trusted
+
+        // Widen whichever bound the score fell outside of and search again.
+        if (result.score <= alpha && alpha > -INFINITE_SCORE)
+          alpha = std::max(alpha - delta, -INFINITE_SCORE);
+        else if (result.score >= beta && beta < INFINITE_SCORE)
+          beta = std::min(beta + delta, INFINITE_SCORE);
+        else
+          break;
+        delta *= 2;
+      }
+    }
+
+    previousScore = result.score;
+    if constexpr (SEARCH_STATS_ENABLED) {
+      const chess::alloc::AllocationCounts allocated =
+          chess::alloc::getThreadAllocations() - allocationsAtStart;
+      stats_.allocations = allocated.allocations;
+      stats_.allocatedBytes = allocated.bytes;
+      stats_.pawnProbes = pawnTable_.getProbes() - pawnProbesAtStart;
+      stats_.pawnHits = pawnTable_.getHits() - pawnHitsAtStart;
+    }
+    principalVariation_.assign(pvTable_[0].begin(),
+                               pvTable_[0].begin() + pvLength_[0]);
+    result_ = {.bestMove = result.bestMove,
+               .score = result.score,
+               .completedDepth = currentDepth,
+               .nodes = getNodes(),
+               .principalVariation = principalVariation_,
+               .stats = stats_};
+
+    if (onIteration)
+      onIteration({.depth = currentDepth,
+                   .score = result.score,
+                   .nodes = getNodes(),
+                   .elapsed = std::chrono::duration_cast<
+                       std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now() - startTime),
+                   .principalVariation = principalVariation_,
+                   .stats = stats_});
+  }
+}
+
+void SearchThread::countNode() {
+  // Only this thread writes the counter, so a plain load and store suffice.
+  const uint64_t nodes = nodes_.load(std::memory_order_relaxed) + 1;
+  nodes_.store(nodes, std::memory_order_relaxed);
+
+  if (result_.completedDepth == 0)
+    return;
+  if (nodeLimit_ && nodes >= nodeLimit_)
+    limitReached_ = true;
+  // Reading the clock costs more than a node, so only every 1024th looks.
+  else if (deadline_ && nodes % 1024 == 0 &&
+           std::chrono::steady_clock::now() >= *deadline_)
+    limitReached_ = true;
+}
+
+SearchThread::MinimaxResult
+SearchThread::minimax(const MinimaxParams &params) {
+  auto [depth, alpha, beta, ply, allowNullMove, followsPv] = params;
+
+  pvLength_[ply] = ply;
+
+  if (isStopped())
+    return {0, {}};
+
+  if (boardState_.onlyKingsLeft())
+    return {0, {}};
+
+  if (ply > 0) {
+    if (isFiftyMoveDraw(boardState_) ||
+        isRepetition(hashHistory_, boardState_.getHalfmoveClock(), ply))
+      return {0, {}};
+
+    // A move back into a position already on this path is a draw the side
+    // to move can always claim.
+    if (alpha < 0 && hasUpcomingRepetition(boardState_, hashHistory_, ply)) {
+      alpha = 0;
+      if (alpha >= beta)
+        return {alpha, {}};
+    }
+  }
+
+  if (depth <= 0 || ply >= MAX_PLY - 1)
+    return {quiescence(alpha, beta, ply), {}};
+
+  countNode();
+  updateSelectiveDepth(stats_, ply);
+
+  const Color turnColor = boardState_.getTurnColor();
+  const bool isPvNode = beta - alpha > 1;
+  const int originalAlpha = alpha;
+  const uint64_t hash = boardState_.getHash();
+
+  Move hashMove{};
+  countStat(stats_.ttProbes);
+  if (auto entry = transpositionTable_.probe(hash)) {
+    countStat(stats_.ttHits);
+    hashMove = entry->move;
+    const int tableScore = scoreFromTable(entry->score, ply);
+    if (!isPvNode && entry->depth >= depth &&
+        (entry->bound == Bound::EXACT ||
+         (entry->bound == Bound::LOWER && tableScore >= beta) ||
+         (entry->bound == Bound::UPPER && tableScore <= alpha))) {
+      countStat(stats_.ttCutoffs);
+      return {tableScore, entry->move};
+    }
+  }
+
+  // Built on first use and shared by the evaluation and move ordering. A
+  // cached evaluation or a cutoff before the moves are ordered needs none.
+  std::optional<AttackMap> attacks;
+  const bool inCheck = chess::move_generator::isInCheck(turnColor, boardState_);
+  const int staticEval = inCheck ? -INFINITE_SCORE : evaluate(&attacks);
+  const SelectivityParams &tuning = selectivityParams_;
+
+  if (!isPvNode && !inCheck) {
+    // Reverse futility: far enough above beta that a quiet move is very
+    // unlikely to give the advantage back this close to the leaves.
+    if (depth <= tuning.reverseFutilityMaxDepth &&
+        staticEval - tuning.reverseFutilityMargin * depth >= beta)
+      return {staticEval, {}};
+
+    // Razoring: hopeless positions near the leaves only get a look at
+    // their captures.
+    if (depth <= tuning.razoringMaxDepth &&
+        staticEval + tuning.razoringMargin * depth < alpha) {
+      const int score = quiescence(alpha, beta, ply);
+      if (score < alpha)
+        return {score, {}};
+    }
+
+    // Null move: if passing still fails high, a real move will too. Not
+    // tried without pieces, where passing may be the only good option.
+    const int nonPawnPieces = countNonPawnPieces(turnColor);
+    if (allowNullMove && depth >= tuning.nullMoveMinDepth &&
+        staticEval >= beta && nonPawnPieces > 0) {
+      const int reduction = tuning.nullMoveBaseReduction +
+                            depth / tuning.nullMoveDepthDivisor;
+
+      countStat(stats_.nullMoveTries);
+      BoardState pieceCopy = boardState_;
+      boardState_.setEnPassantSquare(std::nullopt);
+      boardState_.swapTurnColor();
+      // Nothing before a pass may count as a repetition after it.
+      boardState_.resetHalfmoveClock();
+      hashHistory_.push_back(boardState_.getHash());
+      accumulators_.push(pieceCopy, boardState_);
+      int score = -minimax({.depth = depth - 1 - reduction,
+                            .alpha = -beta,
+                            .beta = -beta + 1,
+                            .ply = static_cast<uint8_t>(ply + 1),
+                            .allowNullMove = false})
+                       .score;
+      boardState_ = pieceCopy;
+      hashHistory_.pop_back();
+      accumulators_.pop();
+
+      if (score >= beta) {
+        if (score >= CHECKMATE_SCORE - MAX_PLY)
+          score = beta; // don't trust mates found by passing
+
+        // Zugzwang is common with few pieces left, so confirm the cutoff
+        // with a reduced search in which passing is not allowed.
+        if (nonPawnPieces > tuning.nullMoveVerificationMaxPieces) {
+          countStat(stats_.nullMoveCutoffs);
+          return {score, {}};
+        }
+        const int verification = minimax({.depth = depth - 1 - reduction,
+                                          .alpha = beta - 1,
+                                          .beta = beta,
+                                          .ply = ply,
+                                          .allowNullMove = false})
+                                     .score;
+        if (verification >= beta) {
+          countStat(stats_.nullMoveCutoffs);
+          return {score, {}};
+        }
+      }
+    }
+  }
+
+  const bool canFutilityPrune =
+      !isPvNode && !inCheck && depth <= tuning.futilityMaxDepth &&
+      staticEval + tuning.futilityMargin * depth <= alpha;
+
+  MoveList moves;
+  chess::move_generator::getPossibleMoves(boardState_, moves);
+  if (!attacks)
+    attacks = chess::move_generator::buildAttackMap(boardState_);
+  // Off the previous principal variation its moves are no better than any
+  // other, even where the same move happens to be legal.
+  const std::optional<Move> pvMove =
+      followsPv && ply < principalVariation_.size()
+          ? std::optional<Move>(principalVariation_[ply])
+          : std::nullopt;
+  orderMoves(moves, ply, hashMove, pvMove, &*attacks);
+
+  Move bestMove{};
+  int bestScore = -INFINITE_SCORE;
+  int legalMoves = 0;
+  MoveList quietsTried;
+
+  for (const Move &move : moves) {
+    const bool isQuiet = !chess::move_generator::isCapture(boardState_, move) &&
+                         !move.isPromotion();
+    BoardState pieceCopy = boardState_;
+
+    chess::move_executor::doMove(boardState_, move);
+    if (chess::move_generator::isInCheck(turnColor, boardState_)) {
+      boardState_ = pieceCopy;
+      continue;
+    }
+    ++legalMoves;
+    hashHistory_.push_back(boardState_.getHash());
+    accumulators_.push(pieceCopy, boardState_);
+
+    const bool givesCheck = chess::move_generator::isInCheck(
+        getOppositeColor(turnColor), boardState_);
+
+    // Futility: quiet moves cannot lift a static score this far below alpha.
+    if (canFutilityPrune && isQuiet && !givesCheck && legalMoves > 1) {
+      boardState_ = pieceCopy;
+      hashHistory_.pop_back();
+      accumulators_.pop();
+      continue;
+    }
+
+    const bool childFollowsPv = move == pvMove;
+    const MinimaxParams childParams{.depth = depth - 1,
+                                    .alpha = -beta,
+                                    .beta = -alpha,
+                                    .ply = static_cast<uint8_t>(ply + 1),
+                                    .followsPv = childFollowsPv};
+    int score;
+    if (legalMoves == 1) {
+      score = -minimax(childParams).score;
+    } else {
+      // Late quiet moves are searched shallower first; a fail high earns
+      // them a full-depth search.
+      int reduction = 0;
+      if (depth >= tuning.lmrMinDepth &&
+          legalMoves > tuning.lmrMinMoveIndex && isQuiet && !inCheck &&
+          !givesCheck && !isKiller(ply, move))
+        reduction = lateMoveReduction(depth, legalMoves,
+                                      getHistory(turnColor, move));
+
+      // Later moves only have to be proven no better than alpha, which a
+      // zero-window search does far more cheaply; re-search on fail high.
+      score = -minimax({.depth = depth - 1 - reduction,
+                        .alpha = -alpha - 1,
+                        .beta = -alpha,
+                        .ply = static_cast<uint8_t>(ply + 1),
+                        .followsPv = childFollowsPv})
+                   .score;
+      if (reduction > 0)
+        countStat(stats_.lmrReductions);
+      if (reduction > 0 && score > alpha) {
+        countStat(stats_.lmrResearches);
+        score = -minimax({.depth = depth - 1,
+                          .alpha = -alpha - 1,
+                          .beta = -alpha,
+                          .ply = static_cast<uint8_t>(ply + 1),
+                          .followsPv = childFollowsPv})
+                     .score;
+      }
+      if (score > alpha && score < beta)
+        score = -minimax(childParams).score;
+    }
+
+    boardState_ = pieceCopy;
+    hashHistory_.pop_back();
+    accumulators_.pop();
+
+    if (isStopped())
+      return {0, {}};
+
+    if (score > bestScore) {
+      bestScore = score;
+      bestMove = move;
+    }
+
+    if (score > alpha) {
+      alpha = score;
+      updatePrincipalVariation(ply, move);
+    }
+
+    if (alpha >= beta) {
+      countStat(stats_.betaCutoffs);
+      if (legalMoves == 1)
+        countStat(stats_.firstMoveCutoffs);
+      if (isQuiet)
+        updateQuietHistory(ply, depth, move, quietsTried);
+      break;
+    }
+
+    if (isQuiet)
+      quietsTried.push_back(move);
+  }
+
+  if (legalMoves == 0) // add ply to prioritize faster mates
+    return {inCheck ? -CHECKMATE_SCORE + ply : 0, {}};
+
+  transpositionTable_.store(
+      hash, {.move = bestMove,
+             .score = scoreToTable(bestScore, ply),
+             .depth = depth,
+             .bound = bestScore >= beta          ? Bound::LOWER
+                      : bestScore > originalAlpha ? Bound::EXACT
+                                                  : Bound::UPPER});
+
+  return {bestScore, bestMove};
+}
+
+int SearchThread::lateMoveReduction(const int depth, const int moveIndex,
+                                    const int history) const {
+  const SelectivityParams &tuning = selectivityParams_;
+  int reduction = static_cast<int>(
+      tuning.lmrBase +
+      std::log(static_cast<float>(depth)) *
+          std::log(static_cast<float>(moveIndex)) / tuning.lmrDivisor);
+
+  // Moves that often caused cutoffs elsewhere are reduced less.
+  reduction -= history / tuning.lmrHistoryDivisor;
+
+  // lmrMinDepth is tunable, so depth - 2 may be negative; std::clamp would
+  // then be undefined.
+  return std::max(0, std::min(reduction, depth - 2));
+}
+
+void SearchThread::updateQuietHistory(const uint8_t ply, const int depth,
+                                      const Move &move,
+                                      const MoveList &quietsTried) {
+  const Color turnColor = boardState_.getTurnColor();
+  const int bonus = std::min(depth * depth, MAX_HISTORY / 4);
+
+  // Scale updates by the distance to the bound so entries saturate
+  // smoothly instead of overflowing.
+  auto applyBonus = [&](const Move &quiet, const int value) {
+    int &entry = history_[static_cast<size_t>(turnColor)]
+                         [quiet.getStartSquare().getIndex()]
+                         [quiet.getEndSquare().getIndex()];
+    entry += value - entry * std::abs(value) / MAX_HISTORY;
+  };
+
+  applyBonus(move, bonus);
+  for (const Move &quiet : quietsTried)
+    applyBonus(quiet, -bonus);
+
+  if (killers_[ply][0] != move) {
+    killers_[ply][1] = killers_[ply][0];
+    killers_[ply][0] = move;
+  }
+}
+
+int SearchThread::getHistory(const Color color, const Move &move) const {
+  return history_[static_cast<size_t>(color)]
+                 [move.getStartSquare().getIndex()]
+                 [move.getEndSquare().getIndex()];
+}
+
+bool SearchThread::isKiller(const uint8_t ply, const Move &move) const {
+  return ply < MAX_PLY &&
+         (killers_[ply][0] == move || killers_[ply][1] == move);
+}
+
+int SearchThread::countNonPawnPieces(const Color color) const {
+  return std::popcount(boardState_.getPieces(color, Name::KNIGHT) |
+                       boardState_.getPieces(color, Name::BISHOP) |
+                       boardState_.getPieces(color, Name::ROOK) |
+                       boardState_.getPieces(color, Name::QUEEN));
+}
+
+void SearchThread::updatePrincipalVariation(const uint8_t ply,
+                                            const Move &move) {
+  pvTable_[ply][ply] = move;
+  for (uint8_t next = ply + 1; next < pvLength_[ply + 1]; ++next)
+    pvTable_[ply][next] = pvTable_[ply + 1][next];
+  pvLength_[ply] = pvLength_[ply + 1];
+}
+
+int SearchThread::quiescence(int alpha, const int beta, const uint8_t ply) {
+  if (isStopped())
+    return 0;
+
+  countNode();
+  countStat(stats_.quiescenceNodes);
+  updateSelectiveDepth(stats_, ply);
+
+  const Color turnColor = boardState_.getTurnColor();
+
+  // Stand pat: the side to move is never forced to capture. At the ply
+  // limit it is the score, however many captures are left, so the path
+  // stays within the accumulator stack and `ply` cannot wrap.
+  const int standPat = evaluate(nullptr);
+  if (standPat >= beta || ply >= MAX_PLY)
+    return standPat;
+  alpha = std::max(alpha, standPat);
+
+  MoveList moves, captures;
+  chess::move_generator::getPossibleMoves(boardState_, moves);
+  for (const Move &move : moves) {
+    if (chess::move_generator::isCapture(boardState_, move))
+      captures.push_back(move);
+  }
+  orderMoves(captures, MAX_PLY, {}, std::nullopt, nullptr);
+
+  int bestScore = standPat;
+  for (const Move &move : captures) {
+    // Captures that lose material outright cannot raise the stand pat score.
+    if (chess::move_generator::staticExchangeEvaluation(boardState_, move) < 0)
+      continue;
+
+    BoardState pieceCopy = boardState_;
+    chess::move_executor::doMove(boardState_, move);
+    if (chess::move_generator::isInCheck(turnColor, boardState_)) {
+      boardState_ = pieceCopy;
+      continue;
+    }
+    accumulators_.push(pieceCopy, boardState_);
+
+    const int score =
+        -quiescence(-beta, -alpha, static_cast<uint8_t>(ply + 1));
+    boardState_ = pieceCopy;
+    accumulators_.pop();
+
+    bestScore = std::max(bestScore, score);
+    alpha = std::max(alpha, score);
+    if (alpha >= beta)
+      break;
+  }
+  return bestScore;
+}
+
+void SearchThread::orderMoves(MoveList &moves, const uint8_t ply,
+                              const Move &hashMove,
+                              const std::optional<Move> &pvMove,
+                              const AttackMap *attacks) const {
+  static constexpr int HASH_MOVE_SCORE = std::numeric_limits<int>::max(),
+                       PV_MOVE_SCORE = HASH_MOVE_SCORE - 1,
+                       GOOD_CAPTURE_SCORE = 3 * MAX_HISTORY,
+                       KILLER_SCORE = 2 * MAX_HISTORY,
+                       BAD_CAPTURE_SCORE = -3 * MAX_HISTORY;
+
+  const Color turnColor = boardState_.getTurnColor();
+
+  // With an attack map, quiet moves that rescue a hanging piece go first and
+  // pieces stepping onto squares an enemy pawn attacks go last.
+  Bitboard hanging = 0ULL, pawnAttacks = 0ULL, enemyAttacks = 0ULL;
+  if (attacks) {
+    const Color enemy = getOppositeColor(turnColor);
+    hanging = chess::move_generator::getHangingPieces(turnColor, boardState_,
+                                                      *attacks);
+    pawnAttacks = attacks->getAttacks(enemy, Name::PAWN);
+    enemyAttacks = attacks->getAttacks(enemy);
+  }
+  const Bitboard pawns = boardState_.getPieces(turnColor, Name::PAWN);
+
+  auto quietScore = [&](const Move &move) -> int {
+    if (isKiller(ply, move))
+      return KILLER_SCORE;
+    int score = getHistory(turnColor, move);
+    const Bitboard start = move.getStartBoard(), end = move.getEndBoard();
+    if (end & pawnAttacks && !(start & pawns))
+      score -= 2 * MAX_HISTORY;
+    else if (start & hanging && !(end & enemyAttacks))
+      score += MAX_HISTORY;
+    return score;
+  };
+
+  // The transposition table move first, then the previous iteration's
+  // principal variation move on a node of that line, winning and even
+  // captures (best exchange first), killers, quiet moves by history, then
+  // captures that lose material.
+  auto orderingScore = [&](const Move &move) -> int {
+    if (move == hashMove && hashMove != Move{})
+      return HASH_MOVE_SCORE;
+    if (move == pvMove)
+      return PV_MOVE_SCORE;
+    if (!chess::move_generator::isCapture(boardState_, move))
+      return quietScore(move);
+    const int exchange =
+        chess::move_generator::staticExchangeEvaluation(boardState_, move);
+    return exchange >= 0 ? GOOD_CAPTURE_SCORE + exchange
+                         : BAD_CAPTURE_SCORE + exchange;
+  };
+
+  std::array<int, MoveList::CAPACITY> scores;
+  for (size_t i = 0; i < moves.size(); ++i)
+    scores[i] = orderingScore(moves[i]);
+
+  // Insertion sort: stable, in place, and quick on lists this short, where
+  // std::stable_sort would allocate a buffer at every node.
+  for (size_t i = 1; i < moves.size(); ++i) {
+    const int score = scores[i];
+    const Move move = moves[i];
+    size_t j = i;
+    for (; j > 0 && scores[j - 1] < score; --j) {
+      scores[j] = scores[j - 1];
+      moves[j] = moves[j - 1];
+    }
+    scores[j] = score;
+    moves[j] = move;
+  }
+}
+
+int SearchThread::evaluate(std::optional<AttackMap> *attacks) {
+  const uint64_t hash = boardState_.getHash();
+  countStat(stats_.evalCacheProbes);
+  if (const std::optional<int> cached = evalCache_.probe(hash)) {
+    countStat(stats_.evalCacheHits);
+    return *cached;
+  }
+  int score;
+  if (network_) {
+    score = accumulators_.evaluate(boardState_, *network_);
+  } else if (attacks) {
+    if (!*attacks)
+      *attacks = chess::move_generator::buildAttackMap(boardState_);
+    score = chess::evaluation::evaluate(boardState_, **attacks, pawnTable_);
+  } else {
+    score = chess::evaluation::evaluate(boardState_, pawnTable_);
+  }
+  evalCache_.store(hash, score);
+  return score;
+}
+#pragma endregion
+
+#pragma region search_pool
+SearchPool::SearchPool(std::shared_ptr<TranspositionTable> sharedTable,
+                       const size_t hashMegabytes)
+    : transpositionTable_(
+          sharedTable ? sharedTable
+                      : std::make_shared<TranspositionTable>(hashMegabytes)),
+      ownsTable_(!sharedTable),
+      mainThread_(std::make_unique<SearchThread>(
+          0, *transpositionTable_, evalCache_, stop_, selectivityParams_,
+          network_)) {}
+
+SearchPool::~SearchPool() { stopHelpers(); }
+
+void SearchPool::setHelperThreadCount(const size_t count) {
+  stopHelpers();
+
+  quit_ = false;
+  for (size_t i = 0; i < count; ++i) {
+    helpers_.push_back(std::make_unique<SearchThread>(
+        i + 1, *transpositionTable_, evalCache_, stop_, selectivityParams_,
+        network_));
+  }
+  for (size_t i = 0; i < count; ++i)
+    helperThreads_.emplace_back(&SearchPool::runHelper, this, i);
+}
+
+void SearchPool::stopHelpers() {
+  {
+    std::lock_guard lock(mutex_);
+    quit_ = true;
+  }
+  startCondition_.notify_all();
+  for (std::thread &thread : helperThreads_)
+    thread.join();
+  helperThreads_.clear();
+  helpers_.clear();
+}
+
+void SearchPool::setHashSize(const size_t megabytes) {
+  setHashSizeInBytes(megabytes << 20);
+}
+
+void SearchPool::setHashSizeInBytes(const size_t bytes) {
+  if (!ownsTable_)
+    throw std::logic_error("Cannot resize a shared transposition table");
+  chess::trace::Scope trace("tt resize", "megabytes",
+                            static_cast<int64_t>(bytes >> 20));
+  transpositionTable_->resizeToBytes(bytes);
+}
+
+void SearchPool::setEvalCacheSize(const size_t megabytes) {
+  evalCache_.resize(megabytes);
+}
+
+void SearchPool::setNetwork(std::shared_ptr<const Network> network) {
+  network_ = std::move(network);
+  // Cached scores came from the other evaluation.
+  evalCache_.clear();
+}
+
+void SearchPool::setSelectivityParams(const SelectivityParams &params) {
+  selectivityParams_ = params;
+}
+
+void SearchPool::setIterationCallback(
+    std::function<void(const IterationInfo &)> callback) {
+  onIteration_ = std::move(callback);
+}
+
+void SearchPool::clearHash() {
+  chess::trace::Scope trace("tt clear");
+  transpositionTable_->clear();
+  evalCache_.clear();
+}
+
+void SearchPool::runHelper(const size_t helperIndex) {
+  chess::trace::setThreadName("helper " + std::to_string(helperIndex + 1));
+  uint64_t lastSearchId = 0;
+
+  while (true) {
+    std::unique_lock lock(mutex_);
+    startCondition_.wait(
+        lock, [&] { return quit_ || searchId_ != lastSearchId; });
+    if (quit_)
+      return;
+    lastSearchId = searchId_;
+    lock.unlock();
+
+    {
+      chess::trace::Scope trace("helper search");
+      helpers_[helperIndex]->search(rootState_, gameHistory_, limits_, {});
+    }
+
+    lock.lock();
+    if (--activeHelpers_ == 0)
+      doneCondition_.notify_all();
+  }
+}
+
+uint64_t SearchPool::getNodes() const {
+  uint64_t nodes = mainThread_->getNodes();
+  for (const auto &helper : helpers_)
+    nodes += helper->getNodes();
+  return nodes;
+}
+
+size_t SearchPool::getMemoryUsage() const {
+  return (ownsTable_ ? transpositionTable_->getSizeInBytes() : 0) +
+         evalCache_.getSizeInBytes() + getSearchMemoryUsage();
+}
+
+size_t SearchPool::getSearchMemoryUsage() const {
+  return (1 + helpers_.size()) * getThreadMemoryUsage() +
+         REPETITION_WINDOW * sizeof(uint64_t);
+}
+
+size_t SearchPool::getEvalCacheSizeInBytes() const {
+  return evalCache_.getSizeInBytes();
+}
+
+size_t SearchPool::getThreadMemoryUsage() {
+  // The hash history, the principal variation and the result's copy of it
+  // are on the heap, at most as large as reserved.
+  return sizeof(SearchThread) +
+         (REPETITION_WINDOW + MAX_PLY) * sizeof(uint64_t) +
+         2 * MAX_PLY * sizeof(Move);
+}
+
+SearchResult SearchPool::search(const BoardState &rootState,
+                                std::span<const uint64_t> gameHistory,
+                                const SearchLimits &limits,
+                                std::stop_token stopToken) {
+  chess::trace::Scope trace("search", "helpers",
+                            static_cast<int64_t>(helpers_.size()));
+  stop_.store(false, std::memory_order_relaxed);
+  // Registered after the reset, so a stop requested before the search even
+  // started still takes effect (the callback then runs right here).
+  std::stop_callback onStop(
+      stopToken, [this] { stop_.store(true, std::memory_order_relaxed); });
+
+  transpositionTable_->newSearch();
+
+  {
+    std::lock_guard lock(mutex_);
+    rootState_ = rootState;
+    const std::span<const uint64_t> window =
+        getRepetitionWindow(gameHistory, rootState);
+    gameHistory_.assign(window.begin(), window.end());
+    limits_ = limits;
+    activeHelpers_ = helpers_.size();
+    ++searchId_;
+  }
+  startCondition_.notify_all();
+
+  // Report the nodes of all threads, not just the main one.
+  mainThread_->search(rootState, gameHistory_, limits,
+                      [&](const IterationInfo &info) {
+                        if (!onIteration_)
+                          return;
+                        IterationInfo poolInfo = info;
+                        poolInfo.nodes = getNodes();
+                        onIteration_(poolInfo);
+                      });
+
+  // Helpers still working on the last depths are of no further use.
+  stop_.store(true, std::memory_order_relaxed);
+  {
+    chess::trace::Scope waitTrace("wait for helpers");
+    std::unique_lock lock(mutex_);
+    doneCondition_.wait(lock, [&] { return activeHelpers_ == 0; });
+  }
+
+  SearchResult best = mainThread_->getResult();
+  for (const auto &helper : helpers_) {
+    const SearchResult &result = helper->getResult();
+    if (result.completedDepth > best.completedDepth)
+      best = result;
+  }
+  best.nodes = getNodes();
+  // All threads are idle again, so their counters can be read safely.
+  best.stats = mainThread_->getStats();
+  for (const auto &helper : helpers_)
+    best.stats += helper->getStats();
+  return best;
+}
+#pragma endregion
+
+} // namespace chess::search
@@ -0,0 +1,310 @@
+module;
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <stop_token>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+export module chess.search;
+
+import chess.core;
+import chess.attack_map;
+import chess.board_state;
+import chess.move;
+import chess.nnue;
+import chess.search_stats;
+import chess.eval_cache;
+import chess.pawn_structure;
+import chess.transposition_table;
+
+export namespace chess::search {
+
+export inline constexpr uint8_t MAX_PLY = 64;
+export inline constexpr int INFINITE_SCORE = 1'000'000;
+export inline constexpr int CHECKMATE_SCORE = 100'000;
+// Game positions a search looks back at for repetitions, the root included.
+export inline constexpr size_t REPETITION_WINDOW = 101;
+
+// Margins and limits of the selective search. Depths are in plies, margins in
+// centipawns; all of them can be changed between searches.
+export struct SelectivityParams {
+  int nullMoveMinDepth = 3;
+  int nullMoveBaseReduction = 2;
+  int nullMoveDepthDivisor = 4;
+  int nullMoveVerificationMaxPieces = 1;
+
+  int lmrMinDepth = 3;
+  int lmrMinMoveIndex = 3;
+  float lmrBase = 0.75f;
+  float lmrDivisor = 2.25f;
+  int lmrHistoryDivisor = 4096;
+
+  int reverseFutilityMaxDepth = 6;
+  int reverseFutilityMargin = 80;
+  int futilityMaxDepth = 3;
+  int futilityMargin = 100;
+  int razoringMaxDepth = 2;
+  int razoringMargin = 300;
+};
+
+// A SelectivityParams field by name, with the range it makes sense in, for
+// everything that sets them from text.
+export template <typename T> struct SelectivityField {
+  std::string_view name;
+  T SelectivityParams::*field;
+  T min, max;
+};
+
+export inline constexpr std::array<SelectivityField<int>, 13>
+    SELECTIVITY_INT_FIELDS = {{
+        {"nullMoveMinDepth", &SelectivityParams::nullMoveMinDepth, 1, MAX_PLY},
+        {"nullMoveBaseReduction", &SelectivityParams::nullMoveBaseReduction,
+         0, MAX_PLY},
+        {"nullMoveDepthDivisor", &SelectivityParams::nullMoveDepthDivisor, 1,
+         MAX_PLY},
+        {"nullMoveVerificationMaxPieces",
+         &SelectivityParams::nullMoveVerificationMaxPieces, 0, 14},
+        {"lmrMinDepth", &SelectivityParams::lmrMinDepth, 1, MAX_PLY},
+        {"lmrMinMoveIndex", &SelectivityParams::lmrMinMoveIndex, 1, 256},
+        {"lmrHistoryDivisor", &SelectivityParams::lmrHistoryDivisor, 1,
+         1 << 20},
+        {"reverseFutilityMaxDepth",
+         &SelectivityParams::reverseFutilityMaxDepth, 0, MAX_PLY},
+        {"reverseFutilityMargin", &SelectivityParams::reverseFutilityMargin, 0,
+         10'000},
+        {"futilityMaxDepth", &SelectivityParams::futilityMaxDepth, 0, MAX_PLY},
+        {"futilityMargin", &SelectivityParams::futilityMargin, 0, 10'000},
+        {"razoringMaxDepth", &SelectivityParams::razoringMaxDepth, 0, MAX_PLY},
+        {"razoringMargin", &SelectivityParams::razoringMargin, 0, 10'000},
+    }};
+
+export inline constexpr std::array<SelectivityField<float>, 2>
+    SELECTIVITY_FLOAT_FIELDS = {{
+        {"lmrBase", &SelectivityParams::lmrBase, 0.0f, 10.0f},
+        {"lmrDivisor", &SelectivityParams::lmrDivisor, 0.1f, 100.0f},
+    }};
+
+// A field missing from the lists above could not be set by name.
+static_assert(sizeof(SelectivityParams) ==
+              SELECTIVITY_INT_FIELDS.size() * sizeof(int) +
+                  SELECTIVITY_FLOAT_FIELDS.size() * sizeof(float));
+
+export struct SearchLimits {
+  int depth = 1;
+  // Nodes per search thread and time since the start, zero for no limit.
+  // They only apply once the first iteration is complete, so a search that
+  // hits them still has a move to return.
+  uint64_t nodes = 0;
+  std::chrono::milliseconds moveTime{0};
+};
+
+// Reported by the main search thread after every completed iteration.
+export struct IterationInfo {
+  int depth;
+  int score;
+  uint64_t nodes;
+  std::chrono::milliseconds elapsed;
+  std::vector<chess::board::Move> principalVariation;
+  SearchStats stats; // the main thread's only
+};
+
+export struct SearchResult {
+  chess::board::Move bestMove{};
+  int score = 0;
+  int completedDepth = 0;
+  uint64_t nodes = 0;
+  std::vector<chess::board::Move> principalVariation;
+  SearchStats stats; // summed over all threads
+};
+
+// One searcher with its own copy of the position and its own move ordering
+// tables. Several of them share a transposition table and a stop flag.
+export class SearchThread {
+private:
+  static constexpr int MAX_HISTORY = 16384;
+
+  struct MinimaxParams {
+    int depth;
+    int alpha, beta;
+    uint8_t ply;
+    bool allowNullMove = true;
+    // Every move from the root to here is the previous iteration's
+    // principal variation, so its next move is worth trying early.
+    bool followsPv = false;
+  };
+
+  struct MinimaxResult {
+    int score;
+    chess::board::Move bestMove;
+  };
+
+  size_t index_;
+  TranspositionTable &transpositionTable_;
+  chess::evaluation::EvalCache &evalCache_;
+  const std::atomic<bool> &stop_;
+  const SelectivityParams &selectivityParams_;
+  // Null while the hand-written evaluation is in use.
+  const std::shared_ptr<const chess::nnue::Network> &network_;
+
+  chess::board::BoardState boardState_{};
+  // Hashes of the game's positions followed by those on the current path.
+  std::vector<uint64_t> hashHistory_;
+  std::atomic<uint64_t> nodes_{0};
+  uint64_t nodeLimit_ = 0;
+  std::optional<std::chrono::steady_clock::time_point> deadline_;
+  bool limitReached_ = false;
+  SearchStats stats_{};
+  SearchResult result_{};
+
+  // Triangular principal variation table: row `ply` holds the best line
+  // found from that ply, filled in as scores are backed up the tree.
+  std::array<std::array<chess::board::Move, MAX_PLY>, MAX_PLY> pvTable_{};
+  std::array<uint8_t, MAX_PLY> pvLength_{};
+  std::vector<chess::board::Move> principalVariation_;
+
+  // Quiet move history, indexed by color, start and end square.
+  std::array<std::array<std::array<int, 64>, 64>,
+             static_cast<size_t>(chess::board::Color::COUNT)>
+      history_{};
+  std::array<std::array<chess::board::Move, 2>, MAX_PLY> killers_{};
+
+  chess::evaluation::PawnTable pawnTable_;
+  chess::nnue::AccumulatorStack accumulators_;
+
+  MinimaxResult minimax(const MinimaxParams &params);
+  int quiescence(int alpha, const int beta, const uint8_t ply);
+  void updatePrincipalVariation(const uint8_t ply,
+                                const chess::board::Move &move);
+  int lateMoveReduction(const int depth, const int moveIndex,
+                        const int history) const;
+  void updateQuietHistory(const uint8_t ply, const int depth,
+                          const chess::board::Move &move,
+                          const chess::board::MoveList &quietsTried);
+  int getHistory(const chess::board::Color color,
+                 const chess::board::Move &move) const;
+  bool isKiller(const uint8_t ply, const chess::board::Move &move) const;
+  int countNonPawnPieces(const chess::board::Color color) const;
+  // Takes the attack map of the node when it has one built.
+  void orderMoves(chess::board::MoveList &moves, const uint8_t ply,
+                  const chess::board::Move &hashMove,
+                  const std::optional<chess::board::Move> &pvMove,
+                  const chess::move_generator::AttackMap *attacks) const;
+  // Builds the node's attack map into `attacks` on an evaluation cache miss
+  // if it is not built yet, so the caller can reuse it; null evaluates
+  // without keeping one.
+  int evaluate(std::optional<chess::move_generator::AttackMap> *attacks);
+  void countNode();
+  // The main thread ignores a stop until depth 1 is complete, so even a
+  // search stopped right away returns a legal move. Helpers stop at once.
+  [[nodiscard]] bool isStopped() const {
+    return limitReached_ ||
+           (stop_.load(std::memory_order_relaxed) &&
+            (index_ != 0 || result_.completedDepth > 0));
+  }
+
+public:
+  SearchThread(size_t index, TranspositionTable &transpositionTable,
+               chess::evaluation::EvalCache &evalCache,
+               const std::atomic<bool> &stop,
+               const SelectivityParams &selectivityParams,
+               const std::shared_ptr<const chess::nnue::Network> &network);
+
+  // Iterative deepening from `rootState` up to `limits.depth`, or until the
+  // stop flag is raised. Helper threads (index > 0) skew their start depth
+  // so they spread over neighbouring iterations.
+  void search(const chess::board::BoardState &rootState,
+              std::span<const uint64_t> gameHistory,
+              const SearchLimits &limits,
+              const std::function<void(const IterationInfo &)> &onIteration);
+
+  [[nodiscard]] const SearchResult &getResult() const { return result_; }
+  [[nodiscard]] uint64_t getNodes() const {
+    return nodes_.load(std::memory_order_relaxed);
+  }
+  [[nodiscard]] const SearchStats &getStats() const { return stats_; }
+};
+
+// Lazy SMP: the calling thread and a pool of helper threads all search the
+// same root and only communicate through the shared transposition table
+// and evaluation cache.
+// The result of the thread with the deepest completed iteration wins.
+export class SearchPool {
+private:
+  SelectivityParams selectivityParams_{};
+  std::shared_ptr<const chess::nnue::Network> network_;
+  std::shared_ptr<TranspositionTable> transpositionTable_;
+  bool ownsTable_;
+  chess::evaluation::EvalCache evalCache_;
+  std::atomic<bool> stop_{false};
+  std::function<void(const IterationInfo &)> onIteration_;
+
+  std::unique_ptr<SearchThread> mainThread_;
+  std::vector<std::unique_ptr<SearchThread>> helpers_;
+  std::vector<std::thread> helperThreads_;
+
+  std::mutex mutex_;
+  std::condition_variable startCondition_, doneCondition_;
+  uint64_t searchId_ = 0;
+  size_t activeHelpers_ = 0;
+  bool quit_ = false;
+  chess::board::BoardState rootState_{};
+  std::vector<uint64_t> gameHistory_;
+  SearchLimits limits_{};
+
+  void runHelper(size_t helperIndex);
+  void stopHelpers();
+
+public:
+  // Without `sharedTable` the pool gets a table of its own of
+  // `hashMegabytes`, a single slot if zero. A shared table may be used by
+  // several pools at once; sizing it is up to its owner.
+  explicit SearchPool(std::shared_ptr<TranspositionTable> sharedTable = {},
+                      size_t hashMegabytes = DEFAULT_HASH_MB);
+  ~SearchPool();
+  SearchPool(const SearchPool &) = delete;
+  SearchPool &operator=(const SearchPool &) = delete;
+
+  void setHelperThreadCount(size_t count);
+  void setHashSize(size_t megabytes);
+  void setHashSizeInBytes(size_t bytes);
+  void setEvalCacheSize(size_t megabytes);
+  void setSelectivityParams(const SelectivityParams &params);
+  // Evaluates with `network` from now on, or by hand if it is null.
+  void setNetwork(std::shared_ptr<const chess::nnue::Network> network);
+  void setIterationCallback(std::function<void(const IterationInfo &)> callback);
+  void clearHash();
+
+  // Nodes searched so far by all threads; safe to call during a search.
+  [[nodiscard]] uint64_t getNodes() const;
+
+  // Memory held by this pool: its own table, if any, the evaluation cache
+  // and per-thread state.
+  [[nodiscard]] size_t getMemoryUsage() const;
+  [[nodiscard]] size_t getEvalCacheSizeInBytes() const;
+  // Per-thread state of every thread and the game history they share.
+  [[nodiscard]] size_t getSearchMemoryUsage() const;
+  [[nodiscard]] static size_t getThreadMemoryUsage();
+  [[nodiscard]] size_t getHelperThreadCount() const { return helpers_.size(); }
+  [[nodiscard]] bool ownsTable() const { return ownsTable_; }
+
+  // `gameHistory` holds the hashes of the positions played so far, ending
+  // with the root, for repetition detection. Blocks until the search is
+  // done; requesting a stop on `stopToken` ends it early.
+  SearchResult search(const chess::board::BoardState &rootState,
+                      std::span<const uint64_t> gameHistory,
+                      const SearchLimits &limits,
+                      std::stop_token stopToken = {});
+};
+
+} // namespace chess::search
@@ -0,0 +1,94 @@
+module;
+
+#include <algorithm>
+#include <cstdint>
+
+export module chess.search_stats;
+
+export namespace chess::search {
+
+// Builds defining CHESS_NO_SEARCH_STATS drop every counter update below at
+// compile time; the counters then simply stay zero.
+#ifdef CHESS_NO_SEARCH_STATS
+export inline constexpr bool SEARCH_STATS_ENABLED = false;
+#else
+export inline constexpr bool SEARCH_STATS_ENABLED = true;
+#endif
+
+// Per thread search counters. Each thread only writes its own copy, so they
+// are plain integers and are only read across threads once a search is over.
+export struct SearchStats {
+  uint64_t quiescenceNodes = 0;
+  uint64_t betaCutoffs = 0;
+  uint64_t firstMoveCutoffs = 0;
+  uint64_t ttProbes = 0;
+  uint64_t ttHits = 0;
+  uint64_t ttCutoffs = 0;
+  uint64_t pawnProbes = 0;
+  uint64_t pawnHits = 0;
+  uint64_t evalCacheProbes = 0;
+  uint64_t evalCacheHits = 0;
+  uint64_t nullMoveTries = 0;
+  uint64_t nullMoveCutoffs = 0;
+  uint64_t lmrReductions = 0;
+  uint64_t lmrResearches = 0;
+  // Heap use over the search, while allocation tracking is on.
+  uint64_t allocations = 0;
+  uint64_t allocatedBytes = 0;
+  int selectiveDepth = 0;
+
+  SearchStats &operator+=(const SearchStats &other) {
+    quiescenceNodes += other.quiescenceNodes;
+    betaCutoffs += other.betaCutoffs;
+    firstMoveCutoffs += other.firstMoveCutoffs;
+    ttProbes += other.ttProbes;
+    ttHits += other.ttHits;
+    ttCutoffs += other.ttCutoffs;
+    pawnProbes += other.pawnProbes;
+    pawnHits += other.pawnHits;
+    evalCacheProbes += other.evalCacheProbes;
+    evalCacheHits += other.evalCacheHits;
+    nullMoveTries += other.nullMoveTries;
+    nullMoveCutoffs += other.nullMoveCutoffs;
+    lmrReductions += other.lmrReductions;
+    lmrResearches += other.lmrResearches;
+    allocations += other.allocations;
+    allocatedBytes += other.allocatedBytes;
+    selectiveDepth = std::max(selectiveDepth, other.selectiveDepth);
+    return *this;
+  }
+
+  // Share of beta cutoffs produced by the first move searched; the closer to
+  // one, the better the move ordering.
+  [[nodiscard]] double firstMoveCutoffRate() const {
+    return betaCutoffs ? static_cast<double>(firstMoveCutoffs) / betaCutoffs
+                       : 0.0;
+  }
+
+  [[nodiscard]] double ttHitRate() const {
+    return ttProbes ? static_cast<double>(ttHits) / ttProbes : 0.0;
+  }
+
+  [[nodiscard]] double pawnHitRate() const {
+    return pawnProbes ? static_cast<double>(pawnHits) / pawnProbes : 0.0;
+  }
+
+  [[nodiscard]] double evalCacheHitRate() const {
+    return evalCacheProbes
+               ? static_cast<double>(evalCacheHits) / evalCacheProbes
+               : 0.0;
+  }
+};
+
+// Counter updates go through these so a no-stats build compiles them out.
+export inline void countStat(uint64_t &counter) {
+  if constexpr (SEARCH_STATS_ENABLED)
+    ++counter;
+}
+
+export inline void updateSelectiveDepth(SearchStats &stats, const int ply) {
+  if constexpr (SEARCH_STATS_ENABLED)
+    stats.selectiveDepth = std::max(stats.selectiveDepth, ply);
+}
+
+} // namespace chess::search
@@ -0,0 +1,262 @@
+module;
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+module chess.selfcheck;
+
+import chess.core;
+import chess.board_state;
+import chess.move;
+import chess.fen;
+import chess.bench;
+import chess.move_executor;
+import chess.move_generator;
+import chess.evaluation;
+import chess.batch_evaluation;
+import chess.nnue;
+
+namespace chess::selfcheck {
+
+using chess::board::Bitboard;
+using chess::board::BoardState;
+using chess::board::Color;
+using chess::board::Move;
+using chess::board::MoveList;
+using chess::board::Name;
+
+namespace {
+
+// Mismatches reported before the rest are only counted.
+constexpr size_t MAX_REPORTED = 5;
+// Deep enough for several bucket crossings, well inside the accumulator
+// stack.
+constexpr size_t MAX_PATH_LENGTH = 64;
+
+// Where a checked position came from, for the report.
+struct Origin {
+  size_t benchPosition;
+  int game, ply;
+};
+
+// Every position of SELFCHECK_GAMES random games from each bench position,
+// with where each came from. Games end early at mate or stalemate.
+void playRandomGames(std::mt19937_64 &random,
+                     std::vector<BoardState> &positions,
+                     std::vector<Origin> &origins) {
+  MoveList legalMoves;
+  for (size_t i = 0; i < chess::bench::BENCH_POSITIONS.size(); ++i) {
+    const std::optional<BoardState> start =
+        chess::board::parseFen(chess::bench::BENCH_POSITIONS[i]);
+    if (!start)
+      throw std::logic_error("Invalid bench position");
+    for (int game = 0; game < SELFCHECK_GAMES; ++game) {
+      BoardState position = *start;
+      for (int ply = 0; ply <= SELFCHECK_PLIES; ++ply) {
+        positions.push_back(position);
+        origins.push_back({i, game, ply});
+        chess::move_generator::getLegalMoves(position, legalMoves);
+        if (legalMoves.empty())
+          break;
+        chess::move_executor::doMove(position,
+                                     legalMoves[random() % legalMoves.size()]);
+      }
+    }
+  }
+}
+
+// A network file of small random weights, so the accumulators can be checked
+// without a trained network at hand. Small enough that no sum overflows.
+void writeRandomNetwork(const std::string &path, const uint64_t seed) {
+  std::mt19937_64 random(seed);
+  std::vector<char> bytes(chess::nnue::NETWORK_FILE_SIZE);
+  std::copy(chess::nnue::NETWORK_MAGIC.begin(),
+            chess::nnue::NETWORK_MAGIC.end(), bytes.begin());
+  const uint32_t header[] = {chess::nnue::NETWORK_VERSION,
+                             chess::nnue::INPUT_SIZE, chess::nnue::HIDDEN_SIZE};
+  for (size_t field = 0; field < 3; ++field) {
+    for (size_t byte = 0; byte < 4; ++byte)
+      bytes[4 + 4 * field + byte] =
+          static_cast<char>(header[field] >> 8 * byte);
+  }
+
+  // int16 weights and biases, then int8 output weights and a zero bias.
+  const size_t weightBytes =
+      (chess::nnue::INPUT_SIZE + 1) * chess::nnue::HIDDEN_SIZE * 2;
+  for (size_t i = 0; i < weightBytes; i += 2) {
+    const auto weight =
+        static_cast<uint16_t>(static_cast<int>(random() % 65) - 32);
+    bytes[chess::nnue::NETWORK_HEADER_SIZE + i] = static_cast<char>(weight);
+    bytes[chess::nnue::NETWORK_HEADER_SIZE + i + 1] =
+        static_cast<char>(weight >> 8);
+  }
+  for (size_t i = 0; i < 2 * chess::nnue::HIDDEN_SIZE; ++i)
+    bytes[chess::nnue::NETWORK_HEADER_SIZE + weightBytes + i] =
+        static_cast<char>(static_cast<int>(random() % 65) - 32);
+
+  std::ofstream file(path, std::ios::binary);
+  if (!file.write(bytes.data(), static_cast<std::streamsize>(bytes.size())) ||
+      !file.flush())
+    throw std::logic_error("Cannot write network to " + path);
+}
+
+// Whether a king move changes its own side's bucket or mirroring, so that
+// the side's accumulator has to be refreshed.
+bool crossesKingBucket(const Color color, const Move &move) {
+  const auto getTransform = [color](const Bitboard square) {
+    return chess::nnue::getKingTransform(
+        color, static_cast<uint8_t>(std::countr_zero(square)));
+  };
+  return getTransform(move.getStartBoard()) != getTransform(move.getEndBoard());
+}
+
+} // namespace
+
+auto checkBatchEvaluation(std::ostream &out, const uint64_t seed) -> bool {
+  std::mt19937_64 random(seed);
+  std::vector<BoardState> positions;
+  std::vector<Origin> origins;
+  playRandomGames(random, positions, origins);
+
+  // All in one batch, so its length is rarely a multiple of the vector width
+  // and the scalar tail is checked too.
+  chess::evaluation::PositionBatch batch;
+  batch.reserve(positions.size());
+  for (const BoardState &position : positions)
+    batch.add(position);
+  std::vector<int> scores(batch.size());
+  chess::evaluation::evaluateBatch(batch, scores);
+
+  size_t mismatches = 0;
+  for (size_t i = 0; i < positions.size(); ++i) {
+    const int expected = chess::evaluation::evaluateStatic(positions[i]);
+    if (scores[i] == expected)
+      continue;
+    if (++mismatches <= MAX_REPORTED)
+      out << "  bench position " << origins[i].benchPosition + 1 << ", game "
+          << origins[i].game + 1 << ", ply " << origins[i].ply
+          << ": evaluateBatch " << scores[i] << ", evaluateStatic "
+          << expected << '\n';
+  }
+  out << "Batch evaluation: " << positions.size() << " positions, "
+      << mismatches << " mismatches" << std::endl;
+  return mismatches == 0;
+}
+
+auto checkAccumulators(std::ostream &out, const chess::nnue::Network &network,
+                       const uint64_t seed) -> bool {
+  std::mt19937_64 random(seed);
+  // Each holds a whole search path of accumulators, too much for the stack.
+  const auto incremental = std::make_unique<chess::nnue::AccumulatorStack>(),
+             fresh = std::make_unique<chess::nnue::AccumulatorStack>();
+  size_t checked = 0, mismatches = 0, crossings = 0;
+  MoveList legalMoves, kingMoves;
+
+  for (size_t i = 0; i < chess::bench::BENCH_POSITIONS.size(); ++i) {
+    const std::optional<BoardState> start =
+        chess::board::parseFen(chess::bench::BENCH_POSITIONS[i]);
+    if (!start)
+      throw std::logic_error("Invalid bench position");
+    for (int game = 0; game < SELFCHECK_GAMES; ++game) {
+      std::vector<BoardState> path{*start};
+      incremental->reset(*start);
+      for (int step = 0; step < SELFCHECK_PLIES; ++step) {
+        const BoardState parent = path.back();
+        const Color turnColor = parent.getTurnColor();
+        chess::move_generator::getLegalMoves(parent, legalMoves);
+
+        // Back up a ply now and then, as a search does after each move.
+        if (path.size() > 1 &&
+            (legalMoves.empty() || path.size() >= MAX_PATH_LENGTH ||
+             random() % 4 == 0)) {
+          path.pop_back();
+          incremental->pop();
+        } else if (legalMoves.empty()) {
+          break;
+        } else {
+          BoardState child = parent;
+          const bool inCheck =
+              chess::move_generator::isInCheck(turnColor, parent);
+          if (!inCheck && random() % 16 == 0) {
+            // A null move, which changes no piece at all.
+            child.setEnPassantSquare(std::nullopt);
+            child.swapTurnColor();
+          } else {
+            const Bitboard king = parent.getPieces(turnColor, Name::KING);
+            kingMoves.clear();
+            for (const Move &move : legalMoves) {
+              if (move.getStartBoard() & king)
+                kingMoves.push_back(move);
+            }
+            // King moves half the time, when there are any.
+            const MoveList &choices =
+                !kingMoves.empty() && random() % 2 ? kingMoves : legalMoves;
+            const Move move = choices[random() % choices.size()];
+            crossings += (move.getStartBoard() & king) &&
+                         crossesKingBucket(turnColor, move);
+            chess::move_executor::doMove(child, move);
+          }
+          incremental->push(parent, child);
+          path.push_back(child);
+        }
+
+        // Only every other position is evaluated, so that some updates
+        // catch up over several plies, as after evaluation cache hits.
+        if (random() % 2)
+          continue;
+        const BoardState &position = path.back();
+        fresh->reset(position);
+        for (const Color perspective : {Color::WHITE, Color::BLACK}) {
+          ++checked;
+          if (incremental->getValues(perspective, position, network) ==
+              fresh->getValues(perspective, position, network))
+            continue;
+          if (++mismatches <= MAX_REPORTED)
+            out << "  bench position " << i + 1 << ", game " << game + 1
+                << ", step " << step << ", depth " << path.size() - 1 << ", "
+                << (perspective == Color::WHITE ? "white" : "black")
+                << " accumulator differs from a refresh\n";
+        }
+      }
+    }
+  }
+  out << "Accumulators: " << checked << " checked, " << crossings
+      << " king bucket crossings, " << mismatches << " mismatches"
+      << std::endl;
+  return mismatches == 0;
+}
+
+auto runSelfCheck(std::ostream &out, const std::string &networkFile) -> bool {
+  bool passed = checkBatchEvaluation(out);
+
+  if (networkFile.empty()) {
+    const std::string path =
+        (std::filesystem::temp_directory_path() / "selfcheck_random.nnue")
+            .string();
+    writeRandomNetwork(path, 1);
+    {
+      // Unmapped before the file goes, which Windows insists on.
+      const std::shared_ptr<const chess::nnue::Network> network =
+          chess::nnue::Network::load(path);
+      passed &= checkAccumulators(out, *network);
+    }
+    std::filesystem::remove(path);
+  } else {
+    passed &= checkAccumulators(out, *chess::nnue::Network::load(networkFile));
+  }
+
+  out << (passed ? "Self-check passed" : "Self-check FAILED") << std::endl;
+  return passed;
+}
+
+} // namespace chess::selfcheck
@@ -0,0 +1,37 @@
+module;
+
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+export module chess.selfcheck;
+
+import chess.nnue;
+
+export namespace chess::selfcheck {
+
+// Random games played from each bench position; every position reached is
+// checked.
+export inline constexpr int SELFCHECK_GAMES = 16;
+export inline constexpr int SELFCHECK_PLIES = 120;
+
+// Compares evaluateBatch with evaluateStatic on every position of seeded
+// random games, reporting the first few that differ. Returns false on any
+// mismatch.
+export auto checkBatchEvaluation(std::ostream &out, uint64_t seed = 1) -> bool;
+
+// Walks seeded random paths through the move tree, backing up now and then
+// as a search does and favouring king moves so that king buckets change
+// often. Along the way it compares the incrementally updated accumulators
+// with ones refreshed from scratch. Returns false on any mismatch.
+export auto checkAccumulators(std::ostream &out,
+                              const chess::nnue::Network &network,
+                              uint64_t seed = 1) -> bool;
+
+// Runs every check, one line each, and returns false if any failed. The
+// accumulators are checked on `networkFile`, or on random weights when it
+// is empty.
+export auto runSelfCheck(std::ostream &out, const std::string &networkFile = {})
+    -> bool;
+
+} // namespace chess::selfcheck
@@ -0,0 +1,66 @@
+module;
+
+#include <cstdlib>
+#include <random>
+
+module chess.selfplay;
+
+import chess.board_state;
+import chess.move;
+import chess.fen;
+import chess.move_executor;
+import chess.move_generator;
+import chess.evaluation;
+
+namespace chess::selfplay {
+
+using chess::board::BoardState;
+using chess::board::Move;
+using chess::board::MoveList;
+
+void Adjudicator::addScore(const int ply, const int whiteScore) {
+  const int resignSign = whiteScore >= params_.resignScore    ? 1
+                         : whiteScore <= -params_.resignScore ? -1
+                                                              : 0;
+  resignPlies_ = !resignSign                      ? 0
+                 : resignSign == lastResignSign_ ? resignPlies_ + 1
+                                                 : 1;
+  lastResignSign_ = resignSign;
+  drawPlies_ = ply >= params_.drawMinPly &&
+                       std::abs(whiteScore) <= params_.drawScore
+                   ? drawPlies_ + 1
+                   : 0;
+}
+
+Verdict Adjudicator::getVerdict() const {
+  if (resignPlies_ >= 2 * params_.resignMoves)
+    return lastResignSign_ > 0 ? Verdict::WHITE_WINS : Verdict::BLACK_WINS;
+  if (drawPlies_ >= 2 * params_.drawMoves)
+    return Verdict::DRAW;
+  return Verdict::NONE;
+}
+
+auto makeRandomOpening(const int plies, std::mt19937_64 &random)
+    -> RandomOpening {
+  static constexpr int MAX_IMBALANCE = 150;
+  const BoardState initial = *chess::board::parseFen(chess::board::START_FEN);
+  MoveList legalMoves;
+  while (true) {
+    RandomOpening opening{{}, initial};
+    for (int ply = 0; ply < plies; ++ply) {
+      chess::move_generator::getLegalMoves(opening.position, legalMoves);
+      if (legalMoves.empty())
+        break;
+      const Move move = legalMoves[random() % legalMoves.size()];
+      chess::move_executor::doMove(opening.position, move);
+      opening.moves.push_back(move);
+    }
+    chess::move_generator::getLegalMoves(opening.position, legalMoves);
+    if (!legalMoves.empty() &&
+        std::abs(chess::evaluation::evaluateStatic(opening.position)) <=
+            MAX_IMBALANCE)
+      return opening;
+  }
+}
+
+} // namespace chess::selfplay
@@ -0,0 +1,52 @@
+module;
+
+#include <cstdint>
+#include <random>
+#include <vector>
+
+export module chess.selfplay;
+
+import chess.board_state;
+import chess.move;
+
+export namespace chess::selfplay {
+
+// Self-play games are given up once the engines agree for resignMoves moves
+// each that one side leads by resignScore, and drawn after drawMinPly once
+// they have scored it within drawScore for drawMoves moves each.
+export struct AdjudicationParams {
+  int resignScore = 1000, resignMoves = 4;
+  int drawScore = 10, drawMoves = 8, drawMinPly = 80;
+};
+
+export enum class Verdict { NONE, WHITE_WINS, BLACK_WINS, DRAW };
+
+// Follows the search scores of a game and says when to stop it early.
+export class Adjudicator {
+private:
+  AdjudicationParams params_;
+  // Plies in a row whose scores met each condition.
+  int resignPlies_ = 0, drawPlies_ = 0, lastResignSign_ = 0;
+
+public:
+  explicit Adjudicator(const AdjudicationParams &params) : params_(params) {}
+
+  // The score of the move played at `ply`, for white.
+  void addScore(int ply, int whiteScore);
+
+  [[nodiscard]] Verdict getVerdict() const;
+};
+
+export struct RandomOpening {
+  std::vector<chess::board::Move> moves;
+  // After the moves.
+  chess::board::BoardState position;
+};
+
+// Random moves from the initial position, redrawn until neither side is
+// clearly better, so the game is about the engines and does not just record
+// a foregone result.
+export auto makeRandomOpening(int plies, std::mt19937_64 &random)
+    -> RandomOpening;
+
+} // namespace chess::selfplay
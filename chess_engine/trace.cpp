@@ -0,0 +1,211 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+module chess.trace;
+
+namespace chess::trace {
+
+namespace {
+
+constexpr size_t BUFFER_CAPACITY = 1 << 15; // events per thread
+
+struct Event {
+  uint64_t timestamp; // nanoseconds since the epoch below
+  const char *name;
+  const char *argName;
+  int64_t argValue;
+  char phase; // 'B'egin, 'E'nd or 'i'nstant, as Chrome spells them
+};
+
+struct ThreadBuffer {
+  std::string threadName;
+  uint32_t threadId;
+  // Cleared when the owning thread exits; guarded by registryMutex.
+  bool owned = true;
+  std::array<Event, BUFFER_CAPACITY> events;
+  // Total events ever written; only the owning thread stores to it.
+  std::atomic<uint64_t> written{0};
+};
+
+std::atomic<bool> enabled{false};
+const auto epoch = std::chrono::steady_clock::now();
+
+// Buffers outlive their threads so a trace can be written after helpers
+// are gone. Those of exited threads move to the free list on clear() and
+// are handed to the next new thread, so a thread per search does not grow
+// the registry.
+std::mutex registryMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> registry;
+std::vector<std::unique_ptr<ThreadBuffer>> freeBuffers;
+uint32_t nextThreadId = 1;
+
+// Gives up the thread's buffer when the thread exits.
+struct BufferHandle {
+  ThreadBuffer *buffer = nullptr;
+
+  ~BufferHandle() {
+    if (buffer) {
+      std::lock_guard lock(registryMutex);
+      buffer->owned = false;
+    }
+  }
+};
+
+thread_local BufferHandle threadBuffer;
+thread_local std::array<char, 32> threadName{};
+
+ThreadBuffer &getThreadBuffer() {
+  if (!threadBuffer.buffer) {
+    std::unique_ptr<ThreadBuffer> buffer;
+    {
+      std::lock_guard lock(registryMutex);
+      if (!freeBuffers.empty()) {
+        buffer = std::move(freeBuffers.back());
+        freeBuffers.pop_back();
+      }
+    }
+    if (!buffer)
+      buffer = std::make_unique<ThreadBuffer>();
+    buffer->threadName = threadName.data();
+    buffer->owned = true;
+    buffer->written.store(0, std::memory_order_relaxed);
+
+    std::lock_guard lock(registryMutex);
+    buffer->threadId = nextThreadId++;
+    if (buffer->threadName.empty())
+      buffer->threadName = "thread " + std::to_string(buffer->threadId);
+    threadBuffer.buffer = registry.emplace_back(std::move(buffer)).get();
+  }
+  return *threadBuffer.buffer;
+}
+
+void record(const char phase, const char *name, const char *argName,
+            const int64_t argValue) {
+  ThreadBuffer &buffer = getThreadBuffer();
+  const uint64_t written = buffer.written.load(std::memory_order_relaxed);
+  buffer.events[written % BUFFER_CAPACITY] = {
+      .timestamp = static_cast<uint64_t>(
+          std::chrono::duration_cast<std::chrono::nanoseconds>(
+              std::chrono::steady_clock::now() - epoch)
+              .count()),
+      .name = name,
+      .argName = argName,
+      .argValue = argValue,
+      .phase = phase};
+  buffer.written.store(written + 1, std::memory_order_release);
+}
+
+void writeEvent(std::ostream &out, const ThreadBuffer &buffer,
+                const Event &event) {
+  out << "{\"name\":\"" << event.name << "\",\"ph\":\"" << event.phase
+      << "\",\"ts\":" << event.timestamp / 1000 << '.' << std::setw(3)
+      << std::setfill('0') << event.timestamp % 1000 << std::setfill(' ')
+      << ",\"pid\":1,\"tid\":" << buffer.threadId;
+  if (event.phase == 'i')
+    out << ",\"s\":\"t\"";
+  if (event.argName)
+    out << ",\"args\":{\"" << event.argName << "\":" << event.argValue << '}';
+  out << '}';
+}
+
+} // namespace
+
+void setEnabled(const bool enable) {
+  enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+
+void setThreadName(const std::string_view name) {
+  const size_t length = std::min(name.size(), threadName.size() - 1);
+  std::copy_n(name.begin(), length, threadName.begin());
+  threadName[length] = '\0';
+  if (threadBuffer.buffer)
+    threadBuffer.buffer->threadName = threadName.data();
+}
+
+void begin(const char *name, const char *argName, const int64_t argValue) {
+  if (isEnabled())
+    record('B', name, argName, argValue);
+}
+
+void end(const char *name) {
+  if (isEnabled())
+    record('E', name, nullptr, 0);
+}
+
+void instant(const char *name, const char *argName, const int64_t argValue) {
+  if (isEnabled())
+    record('i', name, argName, argValue);
+}
+
+Scope::Scope(const char *name, const char *argName, const int64_t argValue)
+    : name_(name), active_(isEnabled()) {
+  if (active_)
+    record('B', name, argName, argValue);
+}
+
+Scope::~Scope() {
+  if (active_)
+    record('E', name_, nullptr, 0);
+}
+
+void writeChromeTrace(std::ostream &out) {
+  std::lock_guard lock(registryMutex);
+  out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+  bool first = true;
+  for (const auto &buffer : registry) {
+    out << (first ? "\n" : ",\n")
+        << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":"
+        << buffer->threadId << ",\"args\":{\"name\":\"" << buffer->threadName
+        << "\"}}";
+    first = false;
+
+    const uint64_t written = buffer->written.load(std::memory_order_acquire);
+    const uint64_t oldest =
+        written > BUFFER_CAPACITY ? written - BUFFER_CAPACITY : 0;
+    // A wrapped ring may have lost the begin of a span whose end it kept;
+    // viewers would close the wrong span on it.
+    int openSpans = 0;
+    for (uint64_t i = oldest; i < written; ++i) {
+      const Event &event = buffer->events[i % BUFFER_CAPACITY];
+      if (event.phase == 'B') {
+        ++openSpans;
+      } else if (event.phase == 'E') {
+        if (openSpans == 0)
+          continue;
+        --openSpans;
+      }
+      out << ",\n";
+      writeEvent(out, *buffer, event);
+    }
+  }
+  out << "\n]}" << std::endl;
+}
+
+void clear() {
+  std::lock_guard lock(registryMutex);
+  const auto exited =
+      std::stable_partition(registry.begin(), registry.end(),
+                            [](const auto &buffer) { return buffer->owned; });
+  std::move(exited, registry.end(), std::back_inserter(freeBuffers));
+  registry.erase(exited, registry.end());
+  for (const auto &buffer : registry)
+    buffer->written.store(0, std::memory_order_relaxed);
+}
+
+} // namespace chess::trace
@@ -0,0 +1,57 @@
+module;
+
+#include <cstdint>
+#include <ostream>
+#include <string_view>
+
+export module chess.trace;
+
+export namespace chess::trace {
+
+// Opt-in timeline of what the search threads did, in the Chrome trace event
+// format (chrome://tracing, Perfetto, speedscope). While disabled every
+// recording call is one relaxed load. While enabled, each thread appends to
+// a ring buffer only it writes to, so recording takes no locks; only a
+// thread's first event registers its buffer, reusing one left by an exited
+// thread if there is one.
+//
+// Event names and argument names must be string literals: only the pointers
+// are kept.
+
+export void setEnabled(bool enabled);
+export [[nodiscard]] bool isEnabled();
+
+// Shown as the calling thread's name in the trace. Cheap; call it once when
+// a thread starts, whether or not tracing is on.
+export void setThreadName(std::string_view name);
+
+export void begin(const char *name, const char *argName = nullptr,
+                  int64_t argValue = 0);
+export void end(const char *name);
+export void instant(const char *name, const char *argName = nullptr,
+                    int64_t argValue = 0);
+
+// Begins on construction and ends on destruction, if tracing was on when it
+// began.
+export class Scope {
+private:
+  const char *name_;
+  bool active_;
+
+public:
+  explicit Scope(const char *name, const char *argName = nullptr,
+                 int64_t argValue = 0);
+  ~Scope();
+  Scope(const Scope &) = delete;
+  Scope &operator=(const Scope &) = delete;
+};
+
+// Writes what every thread recorded as Chrome trace JSON. Only call it while
+// no traced code runs, e.g. after a search. A thread that wrapped its ring
+// keeps only its newest events.
+export void writeChromeTrace(std::ostream &out);
+// Drops everything recorded so far, along with the threads that have exited
+// since the last call.
+export void clear();
+
+} // namespace chess::trace
@@ -0,0 +1,123 @@
+module;
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+module chess.transposition_table;
+
+import chess.move;
+
+namespace chess::search {
+
+namespace {
+
+// Data layout:
+// Bits 0-15: Move
+// Bits 16-47: Score (two's complement)
+// Bits 48-55: Depth
+// Bits 56-57: Bound
+// Bits 58-63: Generation
+constexpr uint64_t pack(const TranspositionEntry &entry,
+                        const uint8_t generation) {
+  return static_cast<uint64_t>(entry.move.data_) |
+         (static_cast<uint64_t>(static_cast<uint32_t>(entry.score)) << 16) |
+         (static_cast<uint64_t>(static_cast<uint8_t>(entry.depth)) << 48) |
+         (static_cast<uint64_t>(entry.bound) << 56) |
+         (static_cast<uint64_t>(generation & 0x3F) << 58);
+}
+
+constexpr TranspositionEntry unpack(const uint64_t data) {
+  chess::board::Move move;
+  move.data_ = static_cast<uint16_t>(data & 0xFFFF);
+  return {move, static_cast<int32_t>(static_cast<uint32_t>(data >> 16)),
+          static_cast<int>(static_cast<uint8_t>(data >> 48)),
+          static_cast<Bound>((data >> 56) & 0x3)};
+}
+
+constexpr uint8_t getGeneration(const uint64_t data) {
+  return static_cast<uint8_t>(data >> 58);
+}
+
+} // namespace
+
+TranspositionTable::TranspositionTable(const size_t megabytes) {
+  resize(megabytes);
+}
+
+void TranspositionTable::resize(const size_t megabytes) {
+  resizeToBytes(megabytes << 20);
+}
+
+void TranspositionTable::resizeToBytes(const size_t bytes) {
+  // Round down to a power of two so the index is a mask of the hash.
+  const size_t requested = bytes / sizeof(Slot);
+  slotCount_ = 1;
+  while (slotCount_ * 2 <= requested)
+    slotCount_ *= 2;
+
+  // Freed first, so the old and the new table are never both held.
+  slots_.reset();
+  slots_ = std::make_unique<Slot[]>(slotCount_);
+  generation_.store(0, std::memory_order_relaxed);
+}
+
+void TranspositionTable::clear() {
+  for (size_t i = 0; i < slotCount_; ++i) {
+    slots_[i].checkedKey.store(0, std::memory_order_relaxed);
+    slots_[i].data.store(0, std::memory_order_relaxed);
+  }
+  generation_.store(0, std::memory_order_relaxed);
+}
+
+void TranspositionTable::newSearch() {
+  generation_.store((generation_.load(std::memory_order_relaxed) + 1) & 0x3F,
+                    std::memory_order_relaxed);
+}
+
+TranspositionTable::Slot &TranspositionTable::getSlot(const uint64_t hash) const {
+  return slots_[hash & (slotCount_ - 1)];
+}
+
+std::optional<TranspositionEntry>
+TranspositionTable::probe(const uint64_t hash) const {
+  const Slot &slot = getSlot(hash);
+  const uint64_t data = slot.data.load(std::memory_order_relaxed);
+  if ((slot.checkedKey.load(std::memory_order_relaxed) ^ data) != hash ||
+      !data)
+    return std::nullopt;
+
+  return unpack(data);
+}
+
+void TranspositionTable::store(const uint64_t hash,
+                               const TranspositionEntry &entry) {
+  Slot &slot = getSlot(hash);
+  const uint8_t generation = generation_.load(std::memory_order_relaxed);
+  const uint64_t oldData = slot.data.load(std::memory_order_relaxed);
+  const bool isSamePosition =
+      (slot.checkedKey.load(std::memory_order_relaxed) ^ oldData) == hash;
+
+  // Keep deeper results of the current search; anything stale or shallower
+  // is overwritten. A same-position entry without a move keeps the old one.
+  if (oldData && getGeneration(oldData) == generation &&
+      entry.bound != Bound::EXACT &&
+      entry.depth < unpack(oldData).depth - (isSamePosition ? 0 : 2))
+    return;
+
+  TranspositionEntry stored = entry;
+  if (isSamePosition && stored.move == chess::board::Move{})
+    stored.move = unpack(oldData).move;
+
+  const uint64_t data = pack(stored, generation);
+  slot.checkedKey.store(hash ^ data, std::memory_order_relaxed);
+  slot.data.store(data, std::memory_order_relaxed);
+}
+
+size_t TranspositionTable::getSizeInBytes() const {
+  return slotCount_ * sizeof(Slot);
+}
+
+} // namespace chess::search
@@ -0,0 +1,60 @@
+module;
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+export module chess.transposition_table;
+
+import chess.move;
+
+export namespace chess::search {
+
+export inline constexpr size_t DEFAULT_HASH_MB = 16;
+
+export enum class Bound : uint8_t { NONE, UPPER, LOWER, EXACT };
+
+export struct TranspositionEntry {
+  chess::board::Move move;
+  int score;
+  int depth;
+  Bound bound;
+};
+
+// Hash table of search results shared by all search threads without locks.
+// Each slot stores its key XORed with its data, so a slot torn by two
+// concurrent writers fails verification on probe instead of returning a
+// mixed-up entry.
+export class TranspositionTable {
+private:
+  struct Slot {
+    std::atomic<uint64_t> checkedKey{0};
+    std::atomic<uint64_t> data{0};
+  };
+
+  std::unique_ptr<Slot[]> slots_;
+  size_t slotCount_ = 0;
+  // Atomic since engines sharing the table each start their own searches.
+  std::atomic<uint8_t> generation_{0};
+
+  [[nodiscard]] Slot &getSlot(uint64_t hash) const;
+
+public:
+  explicit TranspositionTable(size_t megabytes = DEFAULT_HASH_MB);
+
+  void resize(size_t megabytes);
+  // Largest power of two number of slots that fits in `bytes`, at least one.
+  void resizeToBytes(size_t bytes);
+  void clear();
+  // Marks entries from earlier searches as preferred for replacement.
+  void newSearch();
+
+  [[nodiscard]] std::optional<TranspositionEntry> probe(uint64_t hash) const;
+  void store(uint64_t hash, const TranspositionEntry &entry);
+
+  [[nodiscard]] size_t getSizeInBytes() const;
+};
+
+} // namespace chess::search
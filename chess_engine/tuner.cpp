@@ -0,0 +1,645 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+module chess.tuner;
+
+import chess.core;
+import chess.score;
+import chess.eval_parameters;
+import chess.board_state;
+import chess.move;
+import chess.fen;
+import chess.move_executor;
+import chess.move_generator;
+import chess.generator_helpers;
+import chess.pawn_structure;
+import chess.evaluation;
+import chess.datagen;
+
+namespace chess::tuner {
+
+using chess::board::Bitboard;
+using chess::board::BoardState;
+using chess::board::Color;
+using chess::board::Move;
+using chess::board::MoveList;
+using chess::board::Name;
+using chess::board::Score;
+using chess::datagen::TrainingPosition;
+
+namespace {
+
+namespace parameters = chess::evaluation::parameters;
+
+constexpr size_t NAMES = static_cast<size_t>(Name::COUNT);
+
+#pragma region weights
+// Every tuned weight as a middlegame and endgame pair, in the order of the
+// chess.eval_parameters module.
+constexpr size_t MATERIAL = 0, SQUARES = MATERIAL + NAMES,
+                 DOUBLED_PAWN = SQUARES + NAMES * 64,
+                 ISOLATED_PAWN = DOUBLED_PAWN + 1,
+                 BACKWARD_PAWN = ISOLATED_PAWN + 1,
+                 PASSED_PAWN = BACKWARD_PAWN + 1, MOBILITY = PASSED_PAWN + 8,
+                 HANGING_PIECE = MOBILITY + NAMES,
+                 WEIGHT_COUNT = HANGING_PIECE + 1;
+
+using Weights = std::vector<std::array<double, 2>>;
+
+Weights getCurrentWeights() {
+  Weights weights(WEIGHT_COUNT);
+  const auto set = [&](const size_t index, const parameters::Weight weight) {
+    weights[index] = {static_cast<double>(weight.middlegame),
+                      static_cast<double>(weight.endgame)};
+  };
+  for (size_t name = 0; name < NAMES; ++name) {
+    set(MATERIAL + name, {parameters::MIDDLEGAME_VALUES[name],
+                          parameters::ENDGAME_VALUES[name]});
+    for (size_t square = 0; square < 64; ++square)
+      set(SQUARES + name * 64 + square,
+          {parameters::MIDDLEGAME_SQUARES[name][square],
+           parameters::ENDGAME_SQUARES[name][square]});
+    set(MOBILITY + name, parameters::MOBILITY[name]);
+  }
+  set(DOUBLED_PAWN, parameters::DOUBLED_PAWN);
+  set(ISOLATED_PAWN, parameters::ISOLATED_PAWN);
+  set(BACKWARD_PAWN, parameters::BACKWARD_PAWN);
+  for (size_t rank = 0; rank < 8; ++rank)
+    set(PASSED_PAWN + rank, parameters::PASSED_PAWN[rank]);
+  set(HANGING_PIECE, parameters::HANGING_PIECE);
+  return weights;
+}
+#pragma endregion
+
+#pragma region dataset
+// A weight's coefficient in one position, in 16 bits so that tens of
+// millions of positions fit in memory: the weight's index in the low bits,
+// the coefficient, signed, in the rest.
+constexpr int INDEX_BITS = 9;
+constexpr int MAX_COEFFICIENT = (1 << (15 - INDEX_BITS)) - 1;
+static_assert(WEIGHT_COUNT <= 1 << INDEX_BITS);
+
+constexpr uint16_t packFeature(const size_t index, const int coefficient) {
+  return static_cast<uint16_t>(index |
+                               static_cast<unsigned>(coefficient) << INDEX_BITS);
+}
+constexpr size_t getIndex(const uint16_t feature) {
+  return feature & ((1U << INDEX_BITS) - 1);
+}
+constexpr int getCoefficient(const uint16_t feature) {
+  return static_cast<int16_t>(feature) >> INDEX_BITS;
+}
+
+// A quiet position reduced to what the evaluation sees of it: coefficients
+// for the weights that apply, white's count minus black's, and the terms
+// that are not tuned.
+struct TuningPosition {
+  uint64_t firstFeature;
+  Score fixed; // white's advantage
+  uint8_t featureCount;
+  uint8_t phase;
+  uint8_t result; // white's, in half points
+};
+
+struct Dataset {
+  std::vector<TuningPosition> positions;
+  std::vector<uint16_t> features;
+  size_t read = 0, skipped = 0; // lines or labelled positions
+};
+
+constexpr int MAX_QUIESCENCE_DEPTH = 8;
+
+// Fail-soft quiescence search that leaves the last position of its
+// principal variation in `leaf`: the position the stand pat score it
+// settles on actually belongs to.
+int quiesce(const BoardState &boardState, int alpha, const int beta,
+            const int depth, BoardState &leaf) {
+  leaf = boardState;
+  const int standPat = chess::evaluation::evaluate(boardState);
+  if (standPat >= beta || depth == 0)
+    return standPat;
+  alpha = std::max(alpha, standPat);
+
+  const Color turnColor = boardState.getTurnColor();
+  MoveList moves;
+  chess::move_generator::getPossibleMoves(boardState, moves);
+  int bestScore = standPat;
+  BoardState childLeaf;
+  for (const Move &move : moves) {
+    if (!chess::move_generator::isCapture(boardState, move) ||
+        chess::move_generator::staticExchangeEvaluation(boardState, move) < 0)
+      continue;
+    BoardState next = boardState;
+    chess::move_executor::doMove(next, move);
+    if (chess::move_generator::isInCheck(turnColor, next))
+      continue;
+
+    const int score = -quiesce(next, -beta, -alpha, depth - 1, childLeaf);
+    bestScore = std::max(bestScore, score);
+    if (score > alpha) {
+      alpha = score;
+      leaf = childLeaf;
+      if (alpha >= beta)
+        break;
+    }
+  }
+  return bestScore;
+}
+
+std::optional<uint8_t> parseResult(const std::string_view text) {
+  const auto contains = [text](const std::string_view part) {
+    return text.find(part) != std::string_view::npos;
+  };
+  if (contains("1/2-1/2") || contains("[0.5]"))
+    return 1;
+  if (contains("1-0") || contains("[1.0]") || contains("[1]"))
+    return 2;
+  if (contains("0-1") || contains("[0.0]") || contains("[0]"))
+    return 0;
+  return std::nullopt;
+}
+
+// The position and result of one dataset line, unless it is malformed.
+std::optional<TrainingPosition> parseLine(const std::string_view line) {
+  // The board, side to move, castling rights and en passant square, the
+  // only fields EPD and FEN have in common.
+  size_t end = 0;
+  for (int field = 0; field < 4 && end != std::string_view::npos; ++field)
+    end = line.find(' ', line.find_first_not_of(' ', end));
+  const std::optional<uint8_t> result =
+      parseResult(end == std::string_view::npos ? "" : line.substr(end));
+  std::optional<BoardState> root = chess::board::parseFen(line.substr(0, end));
+  if (!result || !root)
+    return std::nullopt;
+  return TrainingPosition{*root, chess::datagen::NO_SCORE, *result};
+}
+
+// Adds a position unless it has the side to move in check (so it has no
+// stand pat score) or has a term too large to pack.
+bool addPosition(const TrainingPosition &sample, Dataset &dataset) {
+  const BoardState &root = sample.position;
+  if (chess::move_generator::isInCheck(root.getTurnColor(), root))
+    return false;
+
+  BoardState quiet;
+  quiesce(root, -std::numeric_limits<int>::max(),
+          std::numeric_limits<int>::max(), MAX_QUIESCENCE_DEPTH, quiet);
+
+  std::array<int, WEIGHT_COUNT> coefficients{};
+  for (const Color color : {Color::WHITE, Color::BLACK}) {
+    const int sign = color == Color::WHITE ? 1 : -1;
+    for (size_t name = 0; name < NAMES; ++name) {
+      Bitboard pieces = quiet.getPieces(color, static_cast<Name>(name));
+      while (auto piece = chess::board::getNextPiece(pieces)) {
+        coefficients[MATERIAL + name] += sign;
+        coefficients[SQUARES + name * 64 +
+                     (color == Color::WHITE ? piece->index
+                                            : piece->index ^ 56)] += sign;
+      }
+    }
+
+    const chess::evaluation::PawnClasses classes =
+        chess::evaluation::classifyPawns(
+            color, quiet.getPieces(color, Name::PAWN),
+            quiet.getPieces(getOppositeColor(color), Name::PAWN));
+    coefficients[DOUBLED_PAWN] += sign * std::popcount(classes.doubled);
+    coefficients[ISOLATED_PAWN] += sign * std::popcount(classes.isolated);
+    coefficients[BACKWARD_PAWN] += sign * std::popcount(classes.backward);
+    Bitboard passed = classes.passed;
+    while (auto pawn = chess::board::getNextPiece(passed))
+      coefficients[PASSED_PAWN + (color == Color::WHITE ? 7 - pawn->index / 8
+                                                        : pawn->index / 8)] +=
+          sign;
+  }
+
+  const chess::evaluation::EvalTrace trace =
+      chess::evaluation::traceEvaluation(quiet);
+  for (size_t name = 0; name < NAMES; ++name)
+    coefficients[MOBILITY + name] = trace.mobility[name];
+  coefficients[HANGING_PIECE] = trace.hangingPieces;
+
+  TuningPosition position{dataset.features.size(), trace.kingDanger, 0,
+                          static_cast<uint8_t>(quiet.getPhase()), sample.result};
+  for (size_t index = 0; index < WEIGHT_COUNT; ++index) {
+    if (!coefficients[index])
+      continue;
+    if (std::abs(coefficients[index]) > MAX_COEFFICIENT) {
+      dataset.features.resize(position.firstFeature);
+      return false;
+    }
+    dataset.features.push_back(packFeature(index, coefficients[index]));
+    ++position.featureCount;
+  }
+  dataset.positions.push_back(position);
+  return true;
+}
+
+// Splits [0, count) into one contiguous range per thread and waits for
+// them all.
+template <typename Work>
+void runParallel(const unsigned threads, const size_t count, const Work &work) {
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (unsigned thread = 0; thread < threads; ++thread) {
+    const size_t begin = count * thread / threads,
+                 end = count * (thread + 1) / threads;
+    workers.emplace_back([&work, thread, begin, end] { work(thread, begin, end); });
+  }
+  for (std::thread &worker : workers)
+    worker.join();
+}
+
+// Positions read per round. Each round is resolved in parallel and its
+// results appended in order, so the dataset is the same whatever the thread
+// count.
+constexpr size_t POSITIONS_PER_ROUND = 1 << 16;
+
+Dataset loadDataset(const TuneOptions &options, const unsigned threads) {
+  // Self-play training data is streamed game by game, a text dataset line
+  // by line; neither is ever held in memory whole.
+  std::optional<chess::datagen::TrainingDataReader> reader;
+  std::ifstream file;
+  if (chess::datagen::isTrainingDataFile(options.datasetFile)) {
+    reader.emplace(options.datasetFile);
+  } else {
+    file.open(options.datasetFile);
+    if (!file)
+      throw std::logic_error("Cannot open dataset " + options.datasetFile);
+  }
+
+  Dataset dataset;
+  std::vector<TrainingPosition> samples;
+  std::vector<Dataset> parts(threads);
+  for (;;) {
+    samples.clear();
+    std::string line;
+    TrainingPosition sample;
+    while (samples.size() < POSITIONS_PER_ROUND &&
+           (!options.maxPositions || dataset.read < options.maxPositions)) {
+      if (reader) {
+        if (!reader->next(sample))
+          break;
+        samples.push_back(sample);
+      } else {
+        if (!std::getline(file, line))
+          break;
+        if (std::optional<TrainingPosition> parsed = parseLine(line))
+          samples.push_back(*parsed);
+        else
+          ++dataset.skipped;
+      }
+      ++dataset.read;
+    }
+    if (samples.empty())
+      break;
+
+    runParallel(threads, samples.size(),
+                [&](const unsigned thread, const size_t begin,
+                    const size_t end) {
+                  Dataset &part = parts[thread];
+                  part.positions.clear();
+                  part.features.clear();
+                  part.skipped = 0;
+                  for (size_t i = begin; i < end; ++i) {
+                    if (!addPosition(samples[i], part))
+                      ++part.skipped;
+                  }
+                });
+
+    for (const Dataset &part : parts) {
+      const uint64_t offset = dataset.features.size();
+      for (TuningPosition position : part.positions) {
+        position.firstFeature += offset;
+        dataset.positions.push_back(position);
+      }
+      dataset.features.insert(dataset.features.end(), part.features.begin(),
+                              part.features.end());
+      dataset.skipped += part.skipped;
+    }
+  }
+  dataset.positions.shrink_to_fit();
+  dataset.features.shrink_to_fit();
+  return dataset;
+}
+#pragma endregion
+
+#pragma region optimization
+// The evaluation as a function of the weights, white's advantage: exactly
+// linear in them but for taper's rounding.
+double evaluatePosition(const Dataset &dataset, const TuningPosition &position,
+                        const Weights &weights) {
+  double middlegame = chess::board::getMiddlegame(position.fixed),
+         endgame = chess::board::getEndgame(position.fixed);
+  for (size_t i = 0; i < position.featureCount; ++i) {
+    const uint16_t feature = dataset.features[position.firstFeature + i];
+    const std::array<double, 2> &weight = weights[getIndex(feature)];
+    middlegame += getCoefficient(feature) * weight[0];
+    endgame += getCoefficient(feature) * weight[1];
+  }
+  return (middlegame * position.phase +
+          endgame * (chess::board::MAX_PHASE - position.phase)) /
+         chess::board::MAX_PHASE;
+}
+
+// Expected result for white of a position white leads by `score`.
+double getExpectedResult(const double scale, const double score) {
+  return 1.0 / (1.0 + std::pow(10.0, -scale * score / 400.0));
+}
+
+// Mean squared error of the expected results, and its gradient with
+// respect to every weight when `gradient` is given.
+double computeError(const Dataset &dataset, const Weights &weights,
+                    const double scale, const unsigned threads,
+                    Weights *gradient = nullptr) {
+  std::vector<double> errors(threads);
+  std::vector<Weights> gradients(gradient ? threads : 0,
+                                 Weights(WEIGHT_COUNT));
+  const double count = static_cast<double>(dataset.positions.size());
+
+  runParallel(threads, dataset.positions.size(),
+              [&](const unsigned thread, const size_t begin, const size_t end) {
+                double error = 0.0;
+                for (size_t i = begin; i < end; ++i) {
+                  const TuningPosition &position = dataset.positions[i];
+                  const double expected = getExpectedResult(
+                      scale, evaluatePosition(dataset, position, weights));
+                  const double difference = expected - position.result / 2.0;
+                  error += difference * difference;
+                  if (!gradient)
+                    continue;
+
+                  // d(error) / d(score), then split between the two halves
+                  // of every weight by the phase.
+                  const double slope = 2.0 * difference * expected *
+                                       (1.0 - expected) * scale *
+                                       std::log(10.0) / 400.0 / count;
+                  const double middlegame =
+                      slope * position.phase / chess::board::MAX_PHASE;
+                  const double endgame =
+                      slope * (chess::board::MAX_PHASE - position.phase) /
+                      chess::board::MAX_PHASE;
+                  Weights &local = gradients[thread];
+                  for (size_t f = 0; f < position.featureCount; ++f) {
+                    const uint16_t feature =
+                        dataset.features[position.firstFeature + f];
+                    std::array<double, 2> &weight = local[getIndex(feature)];
+                    weight[0] += getCoefficient(feature) * middlegame;
+                    weight[1] += getCoefficient(feature) * endgame;
+                  }
+                }
+                errors[thread] = error;
+              });
+
+  if (gradient) {
+    gradient->assign(WEIGHT_COUNT, {0.0, 0.0});
+    for (const Weights &local : gradients)
+      for (size_t index = 0; index < WEIGHT_COUNT; ++index)
+        for (size_t half = 0; half < 2; ++half)
+          (*gradient)[index][half] += local[index][half];
+  }
+  double error = 0.0;
+  for (const double part : errors)
+    error += part;
+  return error / count;
+}
+
+// The scale that best turns the current evaluation into expected results,
+// by golden section search; the error is convex enough in it.
+double fitScale(const Dataset &dataset, const Weights &weights,
+                const unsigned threads) {
+  const double ratio = (std::sqrt(5.0) - 1.0) / 2.0;
+  double low = 0.0, high = 4.0;
+  double left = high - ratio * (high - low), right = low + ratio * (high - low);
+  double leftError = computeError(dataset, weights, left, threads),
+         rightError = computeError(dataset, weights, right, threads);
+  for (int iteration = 0; iteration < 30; ++iteration) {
+    if (leftError < rightError) {
+      high = right;
+      right = left;
+      rightError = leftError;
+      left = high - ratio * (high - low);
+      leftError = computeError(dataset, weights, left, threads);
+    } else {
+      low = left;
+      left = right;
+      leftError = rightError;
+      right = low + ratio * (high - low);
+      rightError = computeError(dataset, weights, right, threads);
+    }
+  }
+  return (low + high) / 2.0;
+}
+#pragma endregion
+
+#pragma region output
+void writeWeight(std::ostream &out, const std::string_view name,
+                 const std::array<double, 2> &weight) {
+  out << "export inline constexpr Weight " << name << " = {"
+      << std::lround(weight[0]) << ", " << std::lround(weight[1]) << "};\n";
+}
+
+void writeWeights(std::ostream &out, const std::string_view name,
+                  const Weights &weights, const size_t first,
+                  const size_t count) {
+  out << "export inline constexpr std::array<Weight, " << count << "> "
+      << name << " = {{\n";
+  for (size_t i = 0; i < count; i += 4) {
+    out << "   ";
+    for (size_t j = i; j < std::min(i + 4, count); ++j)
+      out << " {" << std::lround(weights[first + j][0]) << ", "
+          << std::lround(weights[first + j][1]) << "},";
+    out << '\n';
+  }
+  out << "}};\n";
+}
+
+// Writes the weights as a chess.eval_parameters module, in the layout the
+// checked-in one has, so a run shows up as a plain diff of the numbers.
+void writeParameters(const std::string &path, const Weights &weights) {
+  static constexpr std::array<std::string_view, NAMES> NAME_LABELS = {
+      "Pawn", "Knight", "Bishop", "Rook", "Queen", "King"};
+
+  std::ostringstream out;
+  out << "// Evaluation weights in centipawns, written by `chess_engine "
+         "tune`. A tuning\n"
+         "// run starts from the values here and replaces the whole file.\n"
+         "module;\n\n#include <array>\n\n"
+         "export module chess.eval_parameters;\n\n"
+         "export namespace chess::evaluation::parameters {\n\n"
+         "// A middlegame and an endgame value.\n"
+         "export struct Weight {\n  int middlegame, endgame;\n};\n\n"
+         "export using SquareTables = std::array<std::array<int, 64>, 6>;\n\n"
+         "// Material, indexed by name.\n";
+  for (size_t half = 0; half < 2; ++half) {
+    out << "export inline constexpr std::array<int, 6> "
+        << (half ? "ENDGAME_VALUES" : "MIDDLEGAME_VALUES") << " = {\n    ";
+    for (size_t name = 0; name < NAMES; ++name)
+      out << (name ? ", " : "") << std::lround(weights[MATERIAL + name][half]);
+    out << "};\n";
+  }
+
+  out << "\n// Bonuses for white pieces by name, laid out like the bitboards: "
+         "a8 first,\n// h1 last. Black uses the same tables flipped "
+         "vertically.\n";
+  for (size_t half = 0; half < 2; ++half) {
+    out << "export inline constexpr SquareTables "
+        << (half ? "ENDGAME_SQUARES" : "MIDDLEGAME_SQUARES") << " = {{\n";
+    for (size_t name = 0; name < NAMES; ++name) {
+      out << "    // " << NAME_LABELS[name] << "\n    {\n";
+      for (size_t row = 0; row < 8; ++row) {
+        out << "     ";
+        for (size_t column = 0; column < 8; ++column)
+          out << std::setw(4)
+              << std::lround(weights[SQUARES + name * 64 + row * 8 + column]
+                                    [half])
+              << ',';
+        out << '\n';
+      }
+      out << "    },\n";
+    }
+    out << "}};\n";
+  }
+
+  out << "\n// Pawn structure, per pawn.\n";
+  writeWeight(out, "DOUBLED_PAWN", weights[DOUBLED_PAWN]);
+  writeWeight(out, "ISOLATED_PAWN", weights[ISOLATED_PAWN]);
+  writeWeight(out, "BACKWARD_PAWN", weights[BACKWARD_PAWN]);
+  out << "// Passed pawns by rank, counted from the pawn's own side.\n";
+  writeWeights(out, "PASSED_PAWN", weights, PASSED_PAWN, 8);
+  out << "\n// Per square a piece can move to beyond its baseline, indexed by "
+         "name.\n";
+  writeWeights(out, "MOBILITY", weights, MOBILITY, NAMES);
+  out << "// Per piece attacked and not defended enough.\n";
+  writeWeight(out, "HANGING_PIECE", weights[HANGING_PIECE]);
+  out << "\n} // namespace chess::evaluation::parameters\n";
+
+  std::ofstream file(path, std::ios::binary);
+  if (!(file << out.str()))
+    throw std::logic_error("Cannot write tuned weights to " + path);
+}
+#pragma endregion
+
+} // namespace
+
+void runTuner(std::ostream &out, const TuneOptions &options) {
+  const unsigned threads =
+      options.threads ? options.threads
+                      : std::max(1U, std::thread::hardware_concurrency());
+  const auto start = std::chrono::steady_clock::now();
+  const auto getSeconds = [start] {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() -
+                                         start)
+        .count();
+  };
+
+  const Dataset dataset = loadDataset(options, threads);
+  out << "Loaded " << dataset.positions.size() << " positions from "
+      << dataset.read << " read (" << dataset.skipped << " skipped) in "
+      << std::fixed << std::setprecision(1) << getSeconds() << " s"
+      << std::endl;
+  if (dataset.positions.empty())
+    throw std::logic_error("No usable positions in " + options.datasetFile);
+
+  Weights weights = getCurrentWeights();
+  const double scale = fitScale(dataset, weights, threads);
+  out << "Scale " << std::setprecision(4) << scale << ", error "
+      << std::setprecision(6) << computeError(dataset, weights, scale, threads)
+      << std::endl;
+
+  // Adam: every weight gets a step size of its own, which copes with
+  // material and rarely seen squares sharing one learning rate.
+  static constexpr double BETA1 = 0.9, BETA2 = 0.999, EPSILON = 1e-8;
+  Weights gradient, momentum(WEIGHT_COUNT), velocity(WEIGHT_COUNT);
+  for (int epoch = 1; epoch <= options.epochs; ++epoch) {
+    const double error =
+        computeError(dataset, weights, scale, threads, &gradient);
+    const double momentumCorrection = 1.0 - std::pow(BETA1, epoch),
+                 velocityCorrection = 1.0 - std::pow(BETA2, epoch);
+    for (size_t index = 0; index < WEIGHT_COUNT; ++index) {
+      for (size_t half = 0; half < 2; ++half) {
+        const double g = gradient[index][half];
+        double &m = momentum[index][half], &v = velocity[index][half];
+        m = BETA1 * m + (1.0 - BETA1) * g;
+        v = BETA2 * v + (1.0 - BETA2) * g * g;
+        weights[index][half] -=
+            options.learningRate * (m / momentumCorrection) /
+            (std::sqrt(v / velocityCorrection) + EPSILON);
+      }
+    }
+    if (epoch % 50 == 0 || epoch == options.epochs)
+      out << "Epoch " << epoch << ": error " << error << " ("
+          << std::setprecision(1) << getSeconds() << " s)"
+          << std::setprecision(6) << std::endl;
+  }
+
+  out << "Final error " << computeError(dataset, weights, scale, threads)
+      << std::endl;
+  writeParameters(options.outputFile, weights);
+  out << "Wrote " << options.outputFile << std::endl;
+}
+
+auto parseTuneArguments(const std::span<const std::string_view> words)
+    -> TuneOptions {
+  TuneOptions options;
+  for (const std::string_view word : words) {
+    const size_t equals = word.find('=');
+    const std::string_view key = word.substr(0, equals),
+                           value = equals == std::string_view::npos
+                                       ? std::string_view()
+                                       : word.substr(equals + 1);
+    // The whole value, and above zero where zero means nothing sensible.
+    // Unsigned targets already refuse a minus sign.
+    const auto parse = [&](auto &target, const bool positive) {
+      const auto [end, error] =
+          std::from_chars(value.data(), value.data() + value.size(), target);
+      if (error != std::errc{} || end != value.data() + value.size() ||
+          (positive && !(target > 0)))
+        throw std::logic_error("Invalid value in tune argument " +
+                               std::string(word));
+    };
+    if (key == "epochs") {
+      parse(options.epochs, true);
+    } else if (key == "rate") {
+      parse(options.learningRate, true);
+    } else if (key == "threads") {
+      parse(options.threads, false);
+    } else if (key == "positions") {
+      parse(options.maxPositions, false);
+    } else if (key == "out" && equals != std::string_view::npos) {
+      if (value.empty())
+        throw std::logic_error("Invalid value in tune argument out=");
+      options.outputFile = value;
+    } else if (equals == std::string_view::npos &&
+               options.datasetFile.empty()) {
+      options.datasetFile = word;
+    } else {
+      throw std::logic_error("Unknown tune argument " + std::string(word));
+    }
+  }
+  if (options.datasetFile.empty())
+    throw std::logic_error("No dataset given to tune on");
+  return options;
+}
+
+} // namespace chess::tuner
@@ -0,0 +1,51 @@
+module;
+
+#include <cstddef>
+#include <ostream>
+#include <span>
+#include <string>
+#include <string_view>
+
+export module chess.tuner;
+
+export namespace chess::tuner {
+
+// Not a source file, so a tuning run never overwrites the weights the
+// engine is built with; the result is copied over eval_parameters.ixx by
+// hand once it has been tested.
+export inline constexpr std::string_view DEFAULT_TUNED_FILE =
+    "eval_parameters.tuned";
+
+export struct TuneOptions {
+  // One position per line: a FEN or EPD followed somewhere by the game's
+  // result, as 1-0, 0-1 or 1/2-1/2, or as [1.0], [0.5] or [0.0]. Training
+  // data written by chess::datagen is recognised by its header.
+  std::string datasetFile;
+  // Where the tuned weights are written, as a replacement for the
+  // chess.eval_parameters module.
+  std::string outputFile = std::string(DEFAULT_TUNED_FILE);
+  int epochs = 500;
+  double learningRate = 1.0;
+  // Every core when 0.
+  unsigned threads = 0;
+  // Lines, or labelled positions, read from the dataset; all of them when
+  // 0.
+  size_t maxPositions = 0;
+};
+
+// Texel tuning: resolves every position of the dataset to a quiet one with a
+// quiescence search, fits the scale that maps evaluations to expected game
+// results, then adjusts the evaluation weights by gradient descent on the
+// squared error between those expectations and the actual results. Progress
+// goes to `out`; throws std::logic_error if the dataset cannot be read or
+// the output cannot be written.
+export void runTuner(std::ostream &out, const TuneOptions &options);
+
+// Reads the words after `tune`: the dataset, then any of `epochs=N`,
+// `rate=X`, `threads=N`, `positions=N` and `out=FILE`. Throws
+// std::logic_error on a missing dataset, an unknown word or a value that is
+// not a number in range, so a typo cannot start an hours-long run.
+export auto parseTuneArguments(std::span<const std::string_view> words)
+    -> TuneOptions;
+
+} // namespace chess::tuner
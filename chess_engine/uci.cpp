@@ -0,0 +1,463 @@
+module;
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+module chess.uci;
+
+import chess.core;
+import chess.bench;
+import chess.board_state;
+import chess.fen;
+import chess.move;
+import chess.move_executor;
+import chess.notation;
+import chess.nnue;
+import chess.engine;
+import chess.search;
+import chess.search_stats;
+import chess.trace;
+
+namespace chess::uci {
+
+using chess::board::BoardState;
+using chess::board::Move;
+using chess::search::IterationInfo;
+using chess::search::SearchResult;
+
+namespace {
+
+constexpr size_t DEFAULT_HASH_MB = 16, MAX_HASH_MB = 4096, MAX_THREADS = 64;
+constexpr size_t DEFAULT_EVAL_CACHE_MB = 4, MAX_EVAL_CACHE_MB = 1024;
+// Kept back from the clock for the GUI and the pipe.
+constexpr std::chrono::milliseconds MOVE_OVERHEAD{30};
+
+std::vector<std::string_view> splitWords(std::string_view text) {
+  std::vector<std::string_view> words;
+  while (true) {
+    const size_t start = text.find_first_not_of(" \t\r");
+    if (start == std::string_view::npos)
+      return words;
+    text.remove_prefix(start);
+    const size_t end = std::min(text.find_first_of(" \t\r"), text.size());
+    words.push_back(text.substr(0, end));
+    text.remove_prefix(end);
+  }
+}
+
+// Splits "command rest of line" at the end of the first word.
+std::pair<std::string_view, std::string_view>
+splitCommand(std::string_view line) {
+  const size_t start = line.find_first_not_of(" \t\r");
+  if (start == std::string_view::npos)
+    return {};
+  line.remove_prefix(start);
+  const size_t end = std::min(line.find_first_of(" \t\r"), line.size());
+  return {line.substr(0, end), line.substr(end)};
+}
+
+template <typename T> std::optional<T> parseNumber(std::string_view text) {
+  T value{};
+  const auto [end, error] =
+      std::from_chars(text.data(), text.data() + text.size(), value);
+  if (error != std::errc{} || end != text.data() + text.size())
+    return std::nullopt;
+  return value;
+}
+
+using UciBuffer = std::array<char, chess::notation::MAX_UCI_LENGTH>;
+
+std::string_view encodeUci(UciBuffer &buffer, const Move &move) {
+  const auto result = chess::notation::toUci(
+      buffer.data(), buffer.data() + buffer.size(), move);
+  return {buffer.data(), static_cast<size_t>(result.ptr - buffer.data())};
+}
+
+std::string formatScore(const int score) {
+  using chess::search::CHECKMATE_SCORE, chess::search::MAX_PLY;
+  if (score >= CHECKMATE_SCORE - MAX_PLY)
+    return "mate " + std::to_string((CHECKMATE_SCORE - score + 1) / 2);
+  if (score <= -CHECKMATE_SCORE + MAX_PLY)
+    return "mate " + std::to_string(-(CHECKMATE_SCORE + score) / 2);
+  return "cp " + std::to_string(score);
+}
+
+} // namespace
+
+UciFrontEnd::UciFrontEnd() {
+  position_ = *chess::board::parseFen(chess::board::START_FEN);
+  positionHistory_.assign(1, position_.getHash());
+  engine_.setNetwork(chess::nnue::loadDefaultNetwork());
+  engine_.setProgressCallback(
+      [this](const IterationInfo &info) { printInfo(info); });
+}
+
+UciFrontEnd::~UciFrontEnd() { finishSearch(); }
+
+void UciFrontEnd::run(const bool greeted) {
+  chess::trace::setThreadName("uci");
+  if (greeted)
+    identify();
+
+  std::jthread reader([this] { readInput(); });
+  while (handleCommand(nextCommand())) {
+  }
+}
+
+void UciFrontEnd::readInput() {
+  std::string line;
+  while (std::getline(std::cin, line)) {
+    const bool isQuit = splitCommand(line).first == "quit";
+    {
+      std::lock_guard lock(commandMutex_);
+      commands_.push_back(std::move(line));
+    }
+    commandAvailable_.notify_one();
+    if (isQuit)
+      return;
+  }
+
+  // The GUI went away without saying goodbye.
+  {
+    std::lock_guard lock(commandMutex_);
+    commands_.push_back("quit");
+  }
+  commandAvailable_.notify_one();
+}
+
+std::string UciFrontEnd::nextCommand() {
+  std::unique_lock lock(commandMutex_);
+  commandAvailable_.wait(lock, [&] { return !commands_.empty(); });
+  std::string line = std::move(commands_.front());
+  commands_.pop_front();
+  return line;
+}
+
+bool UciFrontEnd::handleCommand(const std::string_view line) {
+  const auto [command, arguments] = splitCommand(line);
+
+  if (command == "uci")
+    identify();
+  else if (command == "isready")
+    send("readyok");
+  else if (command == "setoption")
+    setOption(arguments);
+  else if (command == "ucinewgame") {
+    finishSearch();
+    engine_.clearHash();
+  } else if (command == "position")
+    setPosition(arguments);
+  else if (command == "go")
+    go(arguments);
+  else if (command == "stop")
+    stop();
+  else if (command == "ponderhit")
+    ponderHit();
+  else if (command == "bench")
+    bench(arguments);
+  else if (command == "quit") {
+    finishSearch();
+    return false;
+  }
+  // Anything else, `debug` and `register` included, is ignored as the
+  // protocol asks.
+  return true;
+}
+
+void UciFrontEnd::identify() {
+  std::ostringstream options;
+  options << "id name chess_engine\n"
+          << "id author Owen Colley\n"
+          << "option name Hash type spin default " << DEFAULT_HASH_MB
+          << " min 1 max " << MAX_HASH_MB << "\n"
+          << "option name Eval Cache type spin default " << DEFAULT_EVAL_CACHE_MB
+          << " min 1 max " << MAX_EVAL_CACHE_MB << "\n"
+          << "option name Threads type spin default 1 min 1 max "
+          << MAX_THREADS << "\n"
+          << "option name Ponder type check default false\n"
+          << "option name Clear Hash type button\n"
+          << "option name Trace File type string default <empty>\n"
+          << "option name EvalFile type string default "
+          << chess::nnue::DEFAULT_NETWORK_FILE << "\n";
+  // UCI has no fractional spin, so the two float fields are strings.
+  for (const auto &[name, field, min, max] :
+       chess::search::SELECTIVITY_INT_FIELDS)
+    options << "option name " << name << " type spin default "
+            << selectivity_.*field << " min " << min << " max " << max
+            << "\n";
+  for (const auto &[name, field, min, max] :
+       chess::search::SELECTIVITY_FLOAT_FIELDS)
+    options << "option name " << name << " type string default "
+            << selectivity_.*field << "\n";
+  options << "uciok";
+  send(options.str());
+}
+
+void UciFrontEnd::setOption(const std::string_view arguments) {
+  // setoption name <id> [value <x>], where the id may contain spaces.
+  const std::vector<std::string_view> words = splitWords(arguments);
+  std::string name, value;
+  std::string *field = nullptr;
+  for (const std::string_view word : words) {
+    if (word == "name")
+      field = &name;
+    else if (word == "value")
+      field = &value;
+    else if (field) {
+      if (!field->empty())
+        *field += ' ';
+      *field += word;
+    }
+  }
+
+  finishSearch();
+  if (name == "Hash") {
+    if (auto megabytes = parseNumber<size_t>(value))
+      engine_.setHashSize(std::clamp<size_t>(*megabytes, 1, MAX_HASH_MB));
+  } else if (name == "Eval Cache") {
+    if (auto megabytes = parseNumber<size_t>(value))
+      engine_.setEvalCacheSize(
+          std::clamp<size_t>(*megabytes, 1, MAX_EVAL_CACHE_MB));
+  } else if (name == "Threads") {
+    if (auto threads = parseNumber<size_t>(value))
+      engine_.setHelperThreadCount(
+          std::clamp<size_t>(*threads, 1, MAX_THREADS) - 1);
+  } else if (name == "Clear Hash") {
+    engine_.clearHash();
+  } else if (name == "EvalFile") {
+    // Without a usable network the hand-written evaluation takes over.
+    std::shared_ptr<const chess::nnue::Network> network;
+    if (value != "<empty>") {
+      try {
+        network = chess::nnue::Network::load(value);
+      } catch (const std::logic_error &error) {
+        send(std::string("info string ") + error.what());
+      }
+    }
+    engine_.setNetwork(std::move(network));
+  } else if (name == "Trace File") {
+    traceFile_ = value == "<empty>" ? "" : value;
+    chess::trace::clear();
+    chess::trace::setEnabled(!traceFile_.empty());
+  }
+
+  const auto setSelectivity = [&](const auto &fields) {
+    for (const auto &[fieldName, field, min, max] : fields) {
+      using Value = std::remove_cvref_t<decltype(min)>;
+      if (name != fieldName)
+        continue;
+      if (const auto parsed = parseNumber<Value>(value)) {
+        selectivity_.*field = std::clamp(*parsed, min, max);
+        engine_.setSelectivityParams(selectivity_);
+      }
+    }
+  };
+  setSelectivity(chess::search::SELECTIVITY_INT_FIELDS);
+  setSelectivity(chess::search::SELECTIVITY_FLOAT_FIELDS);
+  // Ponder only tells us the GUI may send `go ponder`; nothing to set up.
+}
+
+void UciFrontEnd::setPosition(const std::string_view arguments) {
+  finishSearch();
+
+  const std::vector<std::string_view> words = splitWords(arguments);
+  auto movesWord = std::find(words.begin(), words.end(), "moves");
+
+  std::optional<BoardState> position;
+  if (!words.empty() && words[0] == "startpos") {
+    position = chess::board::parseFen(chess::board::START_FEN);
+  } else if (!words.empty() && words[0] == "fen" && words.size() > 1) {
+    const char *fenEnd = movesWord != words.end()
+                             ? movesWord->data()
+                             : words.back().data() + words.back().size();
+    position = chess::board::parseFen(
+        std::string_view(words[1].data(), fenEnd - words[1].data()));
+  }
+  if (!position)
+    return; // keep the previous position rather than a broken one
+
+  position_ = *position;
+  positionHistory_.assign(1, position_.getHash());
+  if (movesWord == words.end())
+    return;
+
+  for (auto word = movesWord + 1; word != words.end(); ++word) {
+    const std::optional<Move> move = chess::notation::parseUci(position_, *word);
+    if (!move)
+      break;
+    chess::move_executor::doMove(position_, *move);
+    positionHistory_.push_back(position_.getHash());
+  }
+}
+
+void UciFrontEnd::go(const std::string_view arguments) {
+  finishSearch();
+
+  const std::vector<std::string_view> words = splitWords(arguments);
+  chess::search::SearchLimits limits{.depth = chess::search::MAX_PLY - 1};
+  std::optional<std::chrono::milliseconds> moveTime, timeLeft;
+  std::chrono::milliseconds increment{0};
+  int movesToGo = 30; // assumed when the time control doesn't say
+  bool ponder = false, infinite = false;
+
+  const bool isWhite = position_.getTurnColor() == chess::board::Color::WHITE;
+  for (size_t i = 0; i < words.size(); ++i) {
+    const std::string_view word = words[i];
+    if (word == "ponder") {
+      ponder = true;
+      continue;
+    }
+    if (word == "infinite") {
+      infinite = true;
+      continue;
+    }
+    if (i + 1 >= words.size())
+      break;
+    const auto number = parseNumber<int64_t>(words[i + 1]);
+    if (!number)
+      continue;
+    ++i;
+
+    if (word == "depth")
+      limits.depth =
+          std::clamp<int>(static_cast<int>(*number), 1, limits.depth);
+    else if (word == "nodes")
+      limits.nodes = static_cast<uint64_t>(std::max<int64_t>(*number, 1));
+    else if (word == "movetime")
+      moveTime = std::chrono::milliseconds(*number);
+    else if (word == "movestogo")
+      movesToGo = std::max<int>(static_cast<int>(*number), 1);
+    else if (word == (isWhite ? "wtime" : "btime"))
+      timeLeft = std::chrono::milliseconds(*number);
+    else if (word == (isWhite ? "winc" : "binc"))
+      increment = std::chrono::milliseconds(*number);
+  }
+
+  // A share of the remaining time plus most of the increment, never more
+  // than what is actually on the clock.
+  std::optional<std::chrono::milliseconds> budget;
+  if (moveTime)
+    budget = *moveTime;
+  else if (timeLeft)
+    budget = std::min(*timeLeft / movesToGo + increment * 3 / 4,
+                      *timeLeft - MOVE_OVERHEAD);
+  if (infinite)
+    budget.reset();
+  if (budget)
+    budget = std::max(*budget, std::chrono::milliseconds(1));
+
+  {
+    std::lock_guard lock(searchMutex_);
+    pondering_ = ponder;
+    infinite_ = infinite;
+  }
+  std::future<SearchResult> result =
+      engine_.start(position_, positionHistory_, limits);
+  searchWatcher_ = std::jthread(
+      [this, result = std::move(result), budget]() mutable {
+        watchSearch(std::move(result), budget);
+      });
+}
+
+void UciFrontEnd::watchSearch(std::future<SearchResult> result,
+                              std::optional<std::chrono::milliseconds> budget) {
+  // While pondering the clock is the opponent's; it starts on ponderhit.
+  // An infinite search only ends on stop.
+  {
+    std::unique_lock lock(searchMutex_);
+    ponderReleased_.wait(lock, [&] { return !pondering_ && !infinite_; });
+  }
+
+  if (budget && result.wait_for(*budget) == std::future_status::timeout)
+    engine_.stop();
+
+  const SearchResult searchResult = result.get();
+  UciBuffer buffer;
+  std::string line = "bestmove ";
+  line += encodeUci(buffer, searchResult.bestMove);
+  if (searchResult.principalVariation.size() >= 2) {
+    line += " ponder ";
+    line += encodeUci(buffer, searchResult.principalVariation[1]);
+  }
+  send(line);
+
+  // Written once the GUI has its move, so the trace costs it no time.
+  if (!traceFile_.empty()) {
+    std::ofstream traceOut(traceFile_);
+    chess::trace::writeChromeTrace(traceOut);
+    chess::trace::clear();
+  }
+}
+
+void UciFrontEnd::stop() {
+  engine_.stop();
+  {
+    std::lock_guard lock(searchMutex_);
+    infinite_ = false;
+  }
+  ponderHit(); // a stopped ponder search still owes its best move
+}
+
+void UciFrontEnd::ponderHit() {
+  {
+    std::lock_guard lock(searchMutex_);
+    pondering_ = false;
+  }
+  ponderReleased_.notify_all();
+}
+
+void UciFrontEnd::finishSearch() {
+  if (!searchWatcher_.joinable())
+    return;
+  stop();
+  searchWatcher_.join();
+}
+
+void UciFrontEnd::bench(const std::string_view arguments) {
+  finishSearch();
+  const chess::bench::BenchOptions options =
+      chess::bench::parseBenchArguments(splitWords(arguments));
+  std::lock_guard lock(outputMutex_);
+  chess::bench::runBench(std::cout, options);
+}
+
+void UciFrontEnd::printInfo(const IterationInfo &info) {
+  const long long milliseconds = info.elapsed.count();
+  std::ostringstream line;
+  line << "info depth " << info.depth;
+  if constexpr (chess::search::SEARCH_STATS_ENABLED)
+    line << " seldepth " << info.stats.selectiveDepth;
+  line << " score " << formatScore(info.score) << " nodes " << info.nodes
+       << " nps "
+       << (milliseconds > 0 ? info.nodes * 1000 / milliseconds : info.nodes)
+       << " time " << milliseconds << " pv";
+  UciBuffer buffer;
+  for (const Move &move : info.principalVariation)
+    line << ' ' << encodeUci(buffer, move);
+  send(line.str());
+}
+
+void UciFrontEnd::send(const std::string_view line) {
+  std::lock_guard lock(outputMutex_);
+  std::cout << line << std::endl;
+}
+
+} // namespace chess::uci
@@ -0,0 +1,83 @@
+module;
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <future>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+export module chess.uci;
+
+import chess.board_state;
+import chess.engine;
+import chess.search;
+
+export namespace chess::uci {
+
+// Universal Chess Interface front end. A dedicated thread does nothing but
+// read stdin, so commands such as `stop` are seen while a search runs; the
+// search itself runs on the engine's thread and a watcher thread reports
+// its best move.
+export class UciFrontEnd {
+private:
+  chess::engine::Engine engine_;
+  chess::board::BoardState position_{};
+  std::vector<uint64_t> positionHistory_;
+  // Where the Chrome trace of each search goes; tracing is off while empty.
+  std::string traceFile_;
+  // Margins and limits of the selective search, one option per field.
+  chess::search::SelectivityParams selectivity_{};
+
+  // Lines handed over by the reader thread, handled in order by run().
+  std::mutex commandMutex_;
+  std::condition_variable commandAvailable_;
+  std::deque<std::string> commands_;
+
+  // Keeps `info` and `bestmove` lines from different threads whole.
+  std::mutex outputMutex_;
+
+  // The search started by the last `go`. While pondering its best move is
+  // held back until `ponderhit` or `stop`, and in an infinite search until
+  // `stop`, even if the search finishes first.
+  std::mutex searchMutex_;
+  std::condition_variable ponderReleased_;
+  bool pondering_ = false;
+  bool infinite_ = false;
+  std::jthread searchWatcher_;
+
+  void readInput();
+  std::string nextCommand();
+  bool handleCommand(std::string_view line);
+
+  void identify();
+  void setOption(std::string_view arguments);
+  void setPosition(std::string_view arguments);
+  void go(std::string_view arguments);
+  void stop();
+  void ponderHit();
+  void finishSearch();
+  void bench(std::string_view arguments);
+  void watchSearch(std::future<chess::search::SearchResult> result,
+                   std::optional<std::chrono::milliseconds> budget);
+
+  void printInfo(const chess::search::IterationInfo &info);
+  void send(std::string_view line);
+
+public:
+  UciFrontEnd();
+  ~UciFrontEnd();
+  UciFrontEnd(const UciFrontEnd &) = delete;
+  UciFrontEnd &operator=(const UciFrontEnd &) = delete;
+
+  // Serves the GUI until `quit` or the end of input. With `greeted` the
+  // GUI's opening `uci` was already read, and is answered right away.
+  void run(bool greeted);
+};
+
+} // namespace chess::uci
@@ -0,0 +1,58 @@
+module;
+
+#include <array>
+#include <cstdint>
+
+export module chess.zobrist;
+
+import chess.core;
+
+export namespace chess::board {
+
+// Random keys XORed into a position hash, one per piece on each square plus
+// the side to move, each lost castling right and the en passant file.
+export struct ZobristKeys {
+  std::array<std::array<std::array<uint64_t, 64>,
+                        static_cast<size_t>(Name::COUNT)>,
+             static_cast<size_t>(Color::COUNT)>
+      pieces{};
+  std::array<uint64_t, 4> castling{};
+  std::array<uint64_t, 8> enPassantFile{};
+  uint64_t blackToMove = 0;
+};
+
+// SplitMix64, so the keys are fixed at compile time and hashes are
+// reproducible between builds.
+constexpr uint64_t nextRandom(uint64_t &state) {
+  uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+  return z ^ (z >> 31);
+}
+
+constexpr ZobristKeys generateKeys() {
+  ZobristKeys keys;
+  uint64_t state = 0x2545F4914F6CDD1DULL;
+
+  for (auto &colorKeys : keys.pieces)
+    for (auto &nameKeys : colorKeys)
+      for (uint64_t &key : nameKeys)
+        key = nextRandom(state);
+  for (uint64_t &key : keys.castling)
+    key = nextRandom(state);
+  for (uint64_t &key : keys.enPassantFile)
+    key = nextRandom(state);
+  keys.blackToMove = nextRandom(state);
+
+  return keys;
+}
+
+export inline constexpr ZobristKeys ZOBRIST_KEYS = generateKeys();
+
+export [[nodiscard]] constexpr uint64_t getPieceKey(Color color, Name name,
+                                                   uint8_t index) {
+  return ZOBRIST_KEYS.pieces[static_cast<size_t>(color)]
+                            [static_cast<size_t>(name)][index];
+}
+
+} // namespace chess::board